@@ -0,0 +1,180 @@
+#include "win32arena.hpp"
+
+// Size class of an allocation, or ARENA_CLASSES if it is too big for one.
+static size_t sizeClass(size_t len) {
+	size_t cls = 0;
+	for (size_t size = ARENA_MIN_CLASS; size < len; size <<= 1)
+		cls++;
+	return cls;
+}
+
+// ------------------------
+// REMOTE ARENA
+// ------------------------
+
+Memory::RemoteArena::RemoteArena(HANDLE rmt_handle, size_t block_size) : handle(rmt_handle), block_size(max(block_size, static_cast<size_t>(0x10000))) {
+	memset(&arena_stats, 0, sizeof(arena_stats));
+	for (size_t i = 0; i < 2; i++) {
+		pools[i].block = 0;
+		pools[i].offset = 0;
+	}
+}
+
+Memory::RemoteArena::~RemoteArena() {
+	release();
+}
+
+// Blocks only get allocated after the current one, so everything before (block, offset) is older
+// than everything after it, which is what marks rely on.
+// When an allocation doesn't fit, the rest of the current block is skipped until the next reset.
+void* Memory::RemoteArena::bump(Pool& p, ArenaPool pool, size_t size) {
+	if (p.block < p.blocks.size() && p.offset + size <= p.blocks[p.block].size) {
+		void* rmt_ptr = p.blocks[p.block].base + p.offset;
+		p.offset += size;
+		return rmt_ptr;
+	}
+
+	size_t next = p.blocks.empty() ? 0 : p.block + 1;
+	if (next >= p.blocks.size() || p.blocks[next].size < size) {
+		// Round up to the allocation granularity, VirtualAllocEx reserves that much anyway.
+		size_t alloc_size = max(block_size, (size + 0xFFFF) & ~static_cast<size_t>(0xFFFF));
+		Block block = { static_cast<byte*>(VirtualAllocEx(handle, 0, alloc_size, MEM_COMMIT | MEM_RESERVE, pool == ARENA_RX ? PAGE_EXECUTE_READWRITE : PAGE_READWRITE)), alloc_size };
+		arena_stats.syscalls++;
+		if (!block.base)
+			return 0;
+
+		p.blocks.insert(p.blocks.begin() + next, block);
+		arena_stats.blocks++;
+		arena_stats.reserved += alloc_size;
+	}
+
+	p.block = next;
+	p.offset = size;
+	return p.blocks[next].base;
+}
+
+void* Memory::RemoteArena::alloc(size_t len, ArenaPool pool) {
+	Pool& p = pools[pool];
+	size_t cls = sizeClass(max(len, static_cast<size_t>(1)));
+	size_t size = cls < ARENA_CLASSES ? ARENA_MIN_CLASS << cls : (len + 15) & ~static_cast<size_t>(15);
+
+	void* rmt_ptr;
+	if (cls < ARENA_CLASSES && !p.free_lists[cls].empty()) {
+		FreeEntry entry = p.free_lists[cls].back();
+		p.free_lists[cls].pop_back();
+		rmt_ptr = p.blocks[entry.block].base + entry.offset;
+	} else {
+		rmt_ptr = bump(p, pool, size);
+		if (!rmt_ptr)
+			return 0;
+	}
+
+	arena_stats.allocs++;
+	arena_stats.used += size;
+	arena_stats.peak = max(arena_stats.peak, arena_stats.used);
+	return rmt_ptr;
+}
+
+void* Memory::RemoteArena::allocWrite(const void* local_src, size_t len, ArenaPool pool) {
+	void* rmt_dst = alloc(len, pool);
+	if (!rmt_dst)
+		return 0;
+
+	arena_stats.syscalls++;
+	if (!WriteProcessMemory(handle, rmt_dst, local_src, len, 0)) {
+		if (free(rmt_dst, len, pool))
+			return 0;
+
+		// Too big for a size class, but it was just bumped, so the bump can be undone.
+		Pool& p = pools[pool];
+		size_t size = (len + 15) & ~static_cast<size_t>(15);
+		if (p.block < p.blocks.size() && static_cast<byte*>(rmt_dst) + size == p.blocks[p.block].base + p.offset) {
+			p.offset -= size;
+			arena_stats.frees++;
+			arena_stats.used -= size;
+		}
+		return 0;
+	}
+
+	return rmt_dst;
+}
+
+bool Memory::RemoteArena::free(void* rmt_ptr, size_t len, ArenaPool pool) {
+	size_t cls = sizeClass(max(len, static_cast<size_t>(1)));
+	if (!rmt_ptr || cls >= ARENA_CLASSES)
+		return false;
+
+	Pool& p = pools[pool];
+	byte* ptr = static_cast<byte*>(rmt_ptr);
+	for (size_t i = 0; i < p.blocks.size(); i++) {
+		if (ptr >= p.blocks[i].base && ptr < p.blocks[i].base + p.blocks[i].size) {
+			FreeEntry entry = { i, static_cast<size_t>(ptr - p.blocks[i].base) };
+			p.free_lists[cls].push_back(entry);
+			arena_stats.frees++;
+			arena_stats.used -= ARENA_MIN_CLASS << cls;
+			return true;
+		}
+	}
+	return false;
+}
+
+Memory::ArenaMark Memory::RemoteArena::mark() const {
+	ArenaMark m;
+	for (size_t i = 0; i < 2; i++) {
+		m.block[i] = pools[i].block;
+		m.offset[i] = pools[i].offset;
+	}
+	m.used = arena_stats.used;
+	return m;
+}
+
+// Space bumped past the mark is given back, and free list entries from past the mark are dropped since
+// that space gets bumped over again.
+void Memory::RemoteArena::reset(const ArenaMark& to) {
+	arena_stats.resets++;
+	for (size_t i = 0; i < 2; i++) {
+		Pool& p = pools[i];
+		if (to.block[i] > p.block || (to.block[i] == p.block && to.offset[i] >= p.offset))
+			continue;
+
+		p.block = to.block[i];
+		p.offset = to.offset[i];
+		for (size_t cls = 0; cls < ARENA_CLASSES; cls++) {
+			std::vector<FreeEntry>& list = p.free_lists[cls];
+			size_t kept = 0;
+			for (size_t j = 0; j < list.size(); j++)
+				if (list[j].block < p.block || (list[j].block == p.block && list[j].offset < p.offset))
+					list[kept++] = list[j];
+			list.resize(kept);
+		}
+	}
+
+	// Allocations from before the mark that were freed or reused since can't be told apart anymore,
+	// so this is approximate if there were any.
+	arena_stats.used = min(arena_stats.used, to.used);
+}
+
+void Memory::RemoteArena::reset() {
+	arena_stats.resets++;
+	arena_stats.used = 0;
+	for (size_t i = 0; i < 2; i++) {
+		pools[i].block = 0;
+		pools[i].offset = 0;
+		for (size_t cls = 0; cls < ARENA_CLASSES; cls++)
+			pools[i].free_lists[cls].clear();
+	}
+}
+
+void Memory::RemoteArena::release() {
+	for (size_t i = 0; i < 2; i++) {
+		for (size_t b = 0; b < pools[i].blocks.size(); b++) {
+			VirtualFreeEx(handle, pools[i].blocks[b].base, 0, MEM_RELEASE);
+			arena_stats.syscalls++;
+		}
+		pools[i].blocks.clear();
+	}
+
+	reset();
+	arena_stats.blocks = 0;
+	arena_stats.reserved = 0;
+}
\ No newline at end of file
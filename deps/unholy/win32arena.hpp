@@ -0,0 +1,141 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <wchar.h>
+#include <Windows.h>
+#include <vector>
+
+#include "win32memory.hpp"
+
+// Default size of the blocks a RemoteArena reserves in the target.
+#define ARENA_BLOCK_SIZE    0x40000
+
+// Allocations up to this size are rounded up to a power of two size class and can be freed for reuse.
+#define ARENA_MIN_CLASS     16
+#define ARENA_MAX_CLASS     2048
+#define ARENA_CLASSES       8
+
+namespace Memory {
+	// Pools of a RemoteArena, data is PAGE_READWRITE and code PAGE_EXECUTE_READWRITE.
+	enum ArenaPool {
+		ARENA_RW,
+		ARENA_RX
+	};
+
+	// Counters of a RemoteArena.
+	struct ArenaStats {
+		size_t blocks;    // Blocks allocated in the target.
+		size_t reserved;  // Bytes of those blocks.
+		size_t used;      // Bytes handed out and not freed or reset.
+		size_t peak;      // Highest used so far.
+		size_t allocs;
+		size_t frees;
+		size_t resets;
+		size_t syscalls;  // VirtualAllocEx / WriteProcessMemory / VirtualFreeEx calls.
+	};
+
+	// Position of a RemoteArena to reset back to.
+	struct ArenaMark {
+		size_t block[2];
+		size_t offset[2];
+		size_t used;
+	};
+
+	// Allocator for small allocations in a remote process.
+	// Memory is taken from large blocks allocated in the target once, so an allocation is a pointer bump
+	// (or a pop from a free list of its size class) plus one write, instead of a VirtualAllocEx each.
+	// Blocks are kept on reset and released when the arena is destroyed. Not thread safe.
+	class RemoteArena {
+	public:
+		explicit RemoteArena(HANDLE rmt_handle, size_t block_size = ARENA_BLOCK_SIZE);
+		~RemoteArena();
+
+		RemoteArena(const RemoteArena&) = delete;
+		RemoteArena& operator=(const RemoteArena&) = delete;
+
+		// Allocate (remote) space, aligned to 16 bytes. Returns 0 if no block could be allocated.
+		void* alloc(size_t len, ArenaPool pool = ARENA_RW);
+
+		// Allocate (remote) space and write bytes to it. If the write fails, 0 is returned and the space is given back.
+		void* allocWrite(const void* local_src, size_t len, ArenaPool pool = ARENA_RW);
+
+		// Allocate (remote) space and write bytes to it.
+		template <typename T>
+		inline T allocWrite(const void* local_src, size_t len, ArenaPool pool = ARENA_RW) {
+			return reinterpret_cast<T>(allocWrite(local_src, len, pool));
+		}
+
+		// Shorthand for allocWrite with pool = ARENA_RX.
+		inline void* allocWriteCode(const void* local_src, size_t len) {
+			return allocWrite(local_src, len, ARENA_RX);
+		}
+
+		// Allocate (remote) space for and write a local string, including its terminator.
+		inline char* allocWriteString(const char* local_src) {
+			return reinterpret_cast<char*>(allocWrite(local_src, strlen(local_src) + 1));
+		}
+
+		// Allocate (remote) space for and write a local wide string, including its terminator.
+		inline wchar_t* allocWriteString(const wchar_t* local_src) {
+			return reinterpret_cast<wchar_t*>(allocWrite(local_src, (wcslen(local_src) + 1) * sizeof(wchar_t)));
+		}
+
+		// Give back an allocation of len bytes so its size class can reuse it.
+		// Allocations bigger than ARENA_MAX_CLASS are only given back by a reset.
+		bool free(void* rmt_ptr, size_t len, ArenaPool pool = ARENA_RW);
+
+		// Current position, to reset back to.
+		ArenaMark mark() const;
+
+		// Give back everything allocated since a mark.
+		void reset(const ArenaMark& to);
+
+		// Give back everything.
+		void reset();
+
+		// Free every block in the target.
+		void release();
+
+		const ArenaStats& stats() const { return arena_stats; }
+
+	private:
+		struct Block {
+			byte* base;
+			size_t size;
+		};
+
+		// Free allocation of a size class, by block index and offset so resets can tell its age.
+		struct FreeEntry {
+			size_t block;
+			size_t offset;
+		};
+
+		struct Pool {
+			std::vector<Block> blocks;
+			size_t block;   // Block being bumped in.
+			size_t offset;  // Bump offset within it.
+			std::vector<FreeEntry> free_lists[ARENA_CLASSES];
+		};
+
+		HANDLE handle;
+		size_t block_size;
+		Pool pools[2];
+		ArenaStats arena_stats;
+
+		void* bump(Pool& p, ArenaPool pool, size_t size);
+	};
+
+	// Resets a RemoteArena back to where it was when the scope was entered.
+	class ArenaScope {
+	public:
+		explicit ArenaScope(RemoteArena& arena) : arena(arena), start(arena.mark()) {}
+		~ArenaScope() { arena.reset(start); }
+
+		ArenaScope(const ArenaScope&) = delete;
+		ArenaScope& operator=(const ArenaScope&) = delete;
+
+	private:
+		RemoteArena& arena;
+		ArenaMark start;
+	};
+}
\ No newline at end of file
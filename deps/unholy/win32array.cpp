@@ -0,0 +1,156 @@
+#include "win32array.hpp"
+
+#include <atomic>
+#include <thread>
+
+// Copy one field of every record into a dense column.
+// The common field sizes get a loop of fixed size copies the compiler turns into plain loads and stores.
+static void transposeColumn(const byte* records, size_t count, uint32_t stride, uint32_t offset, uint32_t size, byte* dst) {
+	const byte* src = records + offset;
+	switch (size) {
+	case 1:
+		for (size_t i = 0; i < count; i++)
+			dst[i] = src[i * stride];
+		break;
+	case 2:
+		for (size_t i = 0; i < count; i++)
+			memcpy(dst + i * 2, src + i * stride, 2);
+		break;
+	case 4:
+		for (size_t i = 0; i < count; i++)
+			memcpy(dst + i * 4, src + i * stride, 4);
+		break;
+	case 8:
+		for (size_t i = 0; i < count; i++)
+			memcpy(dst + i * 8, src + i * stride, 8);
+		break;
+	default:
+		for (size_t i = 0; i < count; i++)
+			memcpy(dst + i * size, src + i * stride, size);
+		break;
+	}
+}
+
+// ------------------------
+// ARRAY COLUMNS
+// ------------------------
+
+size_t Memory::ArrayColumns::add(uint32_t rmt_offset, uint32_t size) {
+	Column column = { rmt_offset, size };
+	cols.push_back(column);
+	return cols.size() - 1;
+}
+
+// ------------------------
+// ARRAY READER
+// ------------------------
+
+Memory::ArrayReader::ArrayReader(RemoteBackend* backend, size_t threads, size_t chunk_size) : backend(backend), threads(max(threads, static_cast<size_t>(1))),
+	chunk_size(max(chunk_size, static_cast<size_t>(0x1000))) {
+	resetStats();
+}
+
+// Run job(chunk, scratch) for every chunk index, on up to threads threads that pull the next index from a
+// shared counter. Each thread has a pooled scratch buffer of chunk_size bytes.
+// Returns the number of chunks whose job failed.
+size_t Memory::ArrayReader::forEachChunk(size_t chunk_count, const std::function<bool(size_t chunk, LocalBuffer& scratch)>& job) {
+	std::atomic<size_t> next(0);
+	std::atomic<size_t> failed(0);
+	auto worker = [&]() {
+		LocalBuffer scratch(chunk_size);
+		for (size_t chunk = next++; chunk < chunk_count; chunk = next++)
+			if (!scratch || !job(chunk, scratch))
+				failed++;
+	};
+
+	size_t count = min(threads, chunk_count);
+	std::vector<std::thread> pool;
+	for (size_t i = 1; i < count; i++)
+		pool.emplace_back(worker);
+	worker();
+	for (size_t i = 0; i < pool.size(); i++)
+		pool[i].join();
+
+	array_stats.chunks += chunk_count;
+	array_stats.failed_chunks += failed;
+	return failed;
+}
+
+// Chunks are read straight into the destination, no scratch needed.
+bool Memory::ArrayReader::read(uint32_t rmt_src, void* local_dst, size_t len) {
+	array_stats.reads++;
+	array_stats.bytes += len;
+	byte* dst = static_cast<byte*>(local_dst);
+	size_t chunk_count = (len + chunk_size - 1) / chunk_size;
+	return forEachChunk(chunk_count, [&](size_t chunk, LocalBuffer&) {
+		size_t offset = chunk * chunk_size;
+		size_t part = min(chunk_size, len - offset);
+		if (backend->read(rmt_src + static_cast<uint32_t>(offset), dst + offset, part))
+			return true;
+		memset(dst + offset, 0, part);
+		return false;
+	}) == 0;
+}
+
+bool Memory::ArrayReader::readVector(uint32_t rmt_vector, size_t elem_size, VectorLayout layout, RemoteVector& vec) {
+	uint32_t offset = layout == VECTOR_MSVC_DEBUG ? sizeof(uint32_t) : 0;
+	memset(&vec, 0, sizeof(vec));
+	if (!elem_size || !backend->read(rmt_vector + offset, &vec, sizeof(vec)))
+		return false;
+
+	// A default constructed vector is all null.
+	if (!vec.first)
+		return !vec.last && !vec.end;
+	if (vec.last < vec.first || vec.end < vec.last || vec.bytes() % elem_size || vec.bytes() > ARRAY_MAX_BYTES) {
+		memset(&vec, 0, sizeof(vec));
+		return false;
+	}
+	return true;
+}
+
+// Records are read a chunk at a time into the worker's scratch buffer and transposed from there, so the
+// records never exist locally as a whole. Chunks cover disjoint rows of the columns.
+bool Memory::ArrayReader::readColumns(uint32_t rmt_src, size_t count, uint32_t stride, ArrayColumns& columns) {
+	if (!stride) {
+		for (size_t c = 0; c < columns.cols.size(); c++)
+			columns.cols[c].data.clear();
+		columns.count = 0;
+		return false;
+	}
+	for (size_t c = 0; c < columns.cols.size(); c++) {
+		if (columns.cols[c].rmt_offset + columns.cols[c].size > stride) {
+			columns.count = 0;
+			return false;
+		}
+		columns.cols[c].data.assign(count * columns.cols[c].size, 0);
+	}
+	columns.count = count;
+
+	array_stats.reads++;
+	array_stats.bytes += count * stride;
+	size_t per_chunk = max(chunk_size / stride, static_cast<size_t>(1));
+	size_t chunk_count = (count + per_chunk - 1) / per_chunk;
+	return forEachChunk(chunk_count, [&](size_t chunk, LocalBuffer& scratch) {
+		size_t first = chunk * per_chunk;
+		size_t n = min(per_chunk, count - first);
+		if (scratch.size() < n * stride && !scratch.resize(n * stride))
+			return false;
+		if (!backend->read(rmt_src + static_cast<uint32_t>(first * stride), scratch.data(), n * stride))
+			return false;
+
+		for (size_t c = 0; c < columns.cols.size(); c++) {
+			ArrayColumns::Column& column = columns.cols[c];
+			transposeColumn(scratch.data(), n, stride, column.rmt_offset, column.size, &column.data[first * column.size]);
+		}
+		return true;
+	}) == 0;
+}
+
+bool Memory::ArrayReader::readVectorColumns(uint32_t rmt_vector, uint32_t stride, ArrayColumns& columns, VectorLayout layout) {
+	RemoteVector vec;
+	if (!readVector(rmt_vector, stride, layout, vec)) {
+		readColumns(0, 0, stride, columns);
+		return false;
+	}
+	return readColumns(vec.first, vec.bytes() / stride, stride, columns);
+}
\ No newline at end of file
@@ -0,0 +1,138 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <Windows.h>
+#include <functional>
+#include <vector>
+
+#include "win32backend.hpp"
+#include "win32buffer.hpp"
+
+// Size of the chunks an ArrayReader reads arrays in.
+#define ARRAY_CHUNK_SIZE   0x40000
+
+// Vectors claiming to hold more than this many bytes are treated as garbage.
+#define ARRAY_MAX_BYTES    0x10000000
+
+namespace Memory {
+	// Where a (32 bit) std::vector keeps its pointers.
+	enum VectorLayout {
+		VECTOR_MSVC,        // first, last, end. MSVC release builds.
+		VECTOR_MSVC_DEBUG,  // Container proxy, then first, last, end. MSVC builds with iterator debugging.
+		VECTOR_LIBSTDCXX    // start, finish, end_of_storage. GCC / MinGW.
+	};
+
+	// The pointers of a remote std::vector.
+	struct RemoteVector {
+		uint32_t first;
+		uint32_t last;
+		uint32_t end;
+
+		size_t bytes() const { return last - first; }
+	};
+
+	// Counters of an ArrayReader.
+	struct ArrayStats {
+		uint64_t reads;          // Arrays read.
+		uint64_t chunks;         // Chunks they were read in.
+		uint64_t failed_chunks;  // Chunks that couldn't be read, their part of the result is zeroed.
+		uint64_t bytes;          // Remote bytes read.
+	};
+
+	// Fields of an array of remote records, read into one local array per field (structure of arrays),
+	// so code that looks at a few fields of every record iterates dense arrays.
+	//   Memory::ArrayColumns cols;
+	//   size_t hp = cols.add<int>(0xF8), pos = cols.add<Vec3>(0x30);
+	//   reader.readColumns(rmt_entities, count, 0x180, cols);
+	//   for (size_t i = 0; i < cols.size(); i++) use(cols.column<int>(hp)[i], cols.column<Vec3>(pos)[i]);
+	class ArrayColumns {
+	public:
+		ArrayColumns() : count(0) {}
+
+		// Read size bytes at an offset of every record into a column. Returns the index of the column.
+		size_t add(uint32_t rmt_offset, uint32_t size);
+
+		// Read a T at an offset of every record into a column. Returns the index of the column.
+		template <typename T>
+		size_t add(uint32_t rmt_offset) {
+			return add(rmt_offset, sizeof(T));
+		}
+
+		// Column as an array of T, 0 if there is no such column or its fields aren't the size of a T.
+		template <typename T>
+		const T* column(size_t idx) const {
+			if (idx >= cols.size() || cols[idx].size != sizeof(T) || !count)
+				return 0;
+			return reinterpret_cast<const T*>(&cols[idx].data[0]);
+		}
+
+		// Records read.
+		size_t size() const { return count; }
+
+		size_t columnCount() const { return cols.size(); }
+
+	private:
+		friend class ArrayReader;
+
+		struct Column {
+			uint32_t rmt_offset;
+			uint32_t size;
+			std::vector<byte> data;
+		};
+
+		std::vector<Column> cols;
+		size_t count;
+	};
+
+	// Reads large (remote) arrays and std::vectors in chunks, optionally on several threads.
+	// With threads > 1 the backend is called from several threads at once, which ProcessBackend and
+	// LocalBackend allow and ViewBackend doesn't. The reader itself is not thread safe.
+	class ArrayReader {
+	public:
+		explicit ArrayReader(RemoteBackend* backend, size_t threads = 1, size_t chunk_size = ARRAY_CHUNK_SIZE);
+
+		// Read len (remote) bytes. Returns false if any chunk couldn't be read, those parts are zeroed.
+		bool read(uint32_t rmt_src, void* local_dst, size_t len);
+
+		// Read count elements of type T.
+		template <typename T>
+		bool read(uint32_t rmt_src, size_t count, std::vector<T>& out) {
+			out.resize(count);
+			return !count || read(rmt_src, &out[0], count * sizeof(T));
+		}
+
+		// Read and check the pointers of a remote std::vector of elements of elem_size bytes.
+		bool readVector(uint32_t rmt_vector, size_t elem_size, VectorLayout layout, RemoteVector& vec);
+
+		// Read the elements of a remote std::vector<T>. T has to have the same size remotely.
+		template <typename T>
+		bool readVector(uint32_t rmt_vector, std::vector<T>& out, VectorLayout layout = VECTOR_MSVC) {
+			RemoteVector vec;
+			if (!readVector(rmt_vector, sizeof(T), layout, vec)) {
+				out.clear();
+				return false;
+			}
+			return read(vec.first, vec.bytes() / sizeof(T), out);
+		}
+
+		// Read the columns of count records of stride bytes.
+		// Returns false if a column doesn't fit the record or any chunk couldn't be read.
+		bool readColumns(uint32_t rmt_src, size_t count, uint32_t stride, ArrayColumns& columns);
+
+		// Read the columns of the records of a remote std::vector whose elements are stride bytes.
+		bool readVectorColumns(uint32_t rmt_vector, uint32_t stride, ArrayColumns& columns, VectorLayout layout = VECTOR_MSVC);
+
+		void setThreads(size_t count) { threads = count ? count : 1; }
+
+		const ArrayStats& stats() const { return array_stats; }
+		void resetStats() { memset(&array_stats, 0, sizeof(array_stats)); }
+
+	private:
+		RemoteBackend* backend;
+		size_t threads;
+		size_t chunk_size;
+		ArrayStats array_stats;
+
+		size_t forEachChunk(size_t chunk_count, const std::function<bool(size_t chunk, LocalBuffer& scratch)>& job);
+	};
+}
\ No newline at end of file
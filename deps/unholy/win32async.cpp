@@ -0,0 +1,221 @@
+#include "win32async.hpp"
+
+#include <chrono>
+
+// ------------------------
+// ASYNC IO
+// ------------------------
+
+Memory::AsyncIO::AsyncIO(RemoteBackend* backend, size_t threads) : backend(backend), stopping(false), in_flight(0) {
+	memset(&async_stats, 0, sizeof(async_stats));
+	threads = max(threads, static_cast<size_t>(1));
+	for (size_t i = 0; i < threads; i++)
+		workers.emplace_back(&AsyncIO::run, this);
+}
+
+Memory::AsyncIO::~AsyncIO() {
+	{
+		std::lock_guard<std::mutex> lock(queue_lock);
+		stopping = true;
+	}
+	queue_cond.notify_all();
+	for (size_t i = 0; i < workers.size(); i++)
+		workers[i].join();
+}
+
+void Memory::AsyncIO::submit(Request&& request) {
+	in_flight++;
+	{
+		std::lock_guard<std::mutex> lock(stats_lock);
+		async_stats.submitted++;
+	}
+	{
+		std::lock_guard<std::mutex> lock(queue_lock);
+		queue.push_back(std::move(request));
+	}
+	queue_cond.notify_one();
+}
+
+std::future<bool> Memory::AsyncIO::read(uint32_t rmt_src, void* local_dst, size_t len) {
+	Request request;
+	request.op = ASYNC_READ;
+	request.address = rmt_src;
+	request.len = len;
+	request.local_dst = local_dst;
+	request.notify = NOTIFY_FUTURE;
+	request.tag = 0;
+	std::future<bool> result = request.promise.get_future();
+	submit(std::move(request));
+	return result;
+}
+
+std::future<bool> Memory::AsyncIO::write(uint32_t rmt_dst, const void* local_src, size_t len) {
+	Request request;
+	request.op = ASYNC_WRITE;
+	request.address = rmt_dst;
+	request.len = len;
+	request.local_dst = 0;
+	request.data.assign(static_cast<const byte*>(local_src), static_cast<const byte*>(local_src) + len);
+	request.notify = NOTIFY_FUTURE;
+	request.tag = 0;
+	std::future<bool> result = request.promise.get_future();
+	submit(std::move(request));
+	return result;
+}
+
+void Memory::AsyncIO::submitRead(uint32_t rmt_src, void* local_dst, size_t len, uint64_t tag) {
+	Request request;
+	request.op = ASYNC_READ;
+	request.address = rmt_src;
+	request.len = len;
+	request.local_dst = local_dst;
+	request.notify = NOTIFY_QUEUE;
+	request.tag = tag;
+	submit(std::move(request));
+}
+
+void Memory::AsyncIO::submitWrite(uint32_t rmt_dst, const void* local_src, size_t len, uint64_t tag) {
+	Request request;
+	request.op = ASYNC_WRITE;
+	request.address = rmt_dst;
+	request.len = len;
+	request.local_dst = 0;
+	request.data.assign(static_cast<const byte*>(local_src), static_cast<const byte*>(local_src) + len);
+	request.notify = NOTIFY_QUEUE;
+	request.tag = tag;
+	submit(std::move(request));
+}
+
+// Coroutines aren't resumed here but queued like tagged requests, so they continue on the thread that
+// polls instead of on an I/O thread.
+void Memory::AsyncIO::complete(Request& request, bool ok) {
+	if (request.notify == NOTIFY_FUTURE) {
+		request.promise.set_value(ok);
+	} else {
+		if (request.notify == NOTIFY_RESUME)
+			*request.result = ok;
+		Completion done = { { request.tag, request.op, request.address, request.len, ok }, request.notify == NOTIFY_RESUME ? request.resume : 0,
+			request.notify == NOTIFY_RESUME ? request.resume_address : 0 };
+		{
+			std::lock_guard<std::mutex> lock(done_lock);
+			completions.push_back(done);
+		}
+		done_cond.notify_all();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(stats_lock);
+		async_stats.completed++;
+		if (!ok)
+			async_stats.failed++;
+	}
+	// Last so drain() can't return before the completion is visible, and under done_lock so drain() can't
+	// miss the wakeup.
+	bool idle;
+	{
+		std::lock_guard<std::mutex> lock(done_lock);
+		idle = --in_flight == 0;
+	}
+	if (idle)
+		done_cond.notify_all();
+}
+
+// Each pass takes everything queued (up to ASYNC_BATCH_MAX). Runs of consecutive reads go out as one
+// readBatch and runs of consecutive writes as one writeBatch, one run after the other, so a write and a
+// later read of the same batch happen in submission order.
+void Memory::AsyncIO::run() {
+	std::vector<Request> batch;
+	std::vector<Memory::Remote::ReadEntry> reads;
+	std::vector<Memory::Remote::WriteEntry> writes;
+	for (;;) {
+		batch.clear();
+		{
+			std::unique_lock<std::mutex> lock(queue_lock);
+			queue_cond.wait(lock, [&]() { return stopping || !queue.empty(); });
+			if (queue.empty())
+				return;
+			size_t count = min(queue.size(), static_cast<size_t>(ASYNC_BATCH_MAX));
+			for (size_t i = 0; i < count; i++) {
+				batch.push_back(std::move(queue.front()));
+				queue.pop_front();
+			}
+			// Leave the rest to another thread.
+			if (!queue.empty())
+				queue_cond.notify_one();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(stats_lock);
+			async_stats.batches++;
+			async_stats.max_batch = max(async_stats.max_batch, batch.size());
+		}
+
+		for (size_t i = 0; i < batch.size();) {
+			size_t end = i;
+			if (batch[i].op == ASYNC_WRITE) {
+				writes.clear();
+				for (; end < batch.size() && batch[end].op == ASYNC_WRITE; end++) {
+					Memory::Remote::WriteEntry write = { reinterpret_cast<void*>(batch[end].address), batch[end].len,
+						batch[end].data.empty() ? 0 : &batch[end].data[0], false };
+					writes.push_back(write);
+				}
+				backend->writeBatch(&writes[0], writes.size());
+				for (size_t w = 0; w < writes.size(); w++)
+					complete(batch[i + w], writes[w].ok);
+				i = end;
+				continue;
+			}
+
+			reads.clear();
+			for (; end < batch.size() && batch[end].op == ASYNC_READ; end++) {
+				Memory::Remote::ReadEntry read = { reinterpret_cast<void*>(batch[end].address), batch[end].len, batch[end].local_dst, false };
+				reads.push_back(read);
+			}
+			backend->readBatch(&reads[0], reads.size());
+			for (size_t r = 0; r < reads.size(); r++)
+				complete(batch[i + r], reads[r].ok);
+			i = end;
+		}
+	}
+}
+
+size_t Memory::AsyncIO::poll(AsyncCompletion* out, size_t max_count) {
+	size_t count = 0;
+	for (;;) {
+		Completion done;
+		{
+			std::lock_guard<std::mutex> lock(done_lock);
+			if (completions.empty() || (count == max_count && !completions.front().resume))
+				return count;
+			done = completions.front();
+			completions.pop_front();
+		}
+
+		if (done.resume)
+			done.resume(done.resume_address);
+		else
+			out[count++] = done.info;
+	}
+}
+
+size_t Memory::AsyncIO::wait(AsyncCompletion* out, size_t max_count, DWORD timeout_ms) {
+	{
+		std::unique_lock<std::mutex> lock(done_lock);
+		auto ready = [&]() { return !completions.empty(); };
+		if (timeout_ms == INFINITE)
+			done_cond.wait(lock, ready);
+		else
+			done_cond.wait_for(lock, std::chrono::milliseconds(timeout_ms), ready);
+	}
+	return poll(out, max_count);
+}
+
+void Memory::AsyncIO::drain() {
+	std::unique_lock<std::mutex> lock(done_lock);
+	done_cond.wait(lock, [&]() { return in_flight == 0; });
+}
+
+Memory::AsyncStats Memory::AsyncIO::stats() {
+	std::lock_guard<std::mutex> lock(stats_lock);
+	return async_stats;
+}
\ No newline at end of file
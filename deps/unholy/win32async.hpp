@@ -0,0 +1,200 @@
+#pragma once
+#include <stdint.h>
+#include <Windows.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+#include <coroutine>
+#define ASYNC_COROUTINES
+#endif
+
+#include "win32backend.hpp"
+
+// I/O threads an AsyncIO starts unless told otherwise.
+#define ASYNC_DEFAULT_THREADS  2
+
+// Most requests an I/O thread takes off the queue at once.
+#define ASYNC_BATCH_MAX        256
+
+namespace Memory {
+	enum AsyncOp {
+		ASYNC_READ,
+		ASYNC_WRITE
+	};
+
+	// A finished request that was submitted with a tag.
+	struct AsyncCompletion {
+		uint64_t tag;
+		AsyncOp op;
+		uint32_t address;
+		size_t len;
+		bool ok;
+	};
+
+	// Counters of an AsyncIO.
+	struct AsyncStats {
+		uint64_t submitted;
+		uint64_t completed;
+		uint64_t failed;
+		uint64_t batches;    // Batches the I/O threads took off the queue.
+		size_t max_batch;    // Biggest of those.
+
+		// Requests per batch, on average. Grows with the number of requests kept in flight.
+		double batchMean() const { return batches ? static_cast<double>(completed) / batches : 0.0; }
+	};
+
+	class AsyncIO;
+
+#ifdef ASYNC_COROUTINES
+	// co_await on AsyncIO::readAwait / writeAwait. Resumes from AsyncIO::poll or wait, on the thread calling
+	// it, and gives whether the request worked.
+	class AsyncAwaitable {
+	public:
+		AsyncAwaitable(AsyncIO& io, AsyncOp op, uint32_t address, void* local, const void* local_src, size_t len) : io(io), op(op), address(address),
+			local(local), local_src(local_src), len(len), result(false) {}
+
+		bool await_ready() const { return false; }
+		void await_suspend(std::coroutine_handle<> handle);
+		bool await_resume() const { return result; }
+
+	private:
+		AsyncIO& io;
+		AsyncOp op;
+		uint32_t address;
+		void* local;
+		const void* local_src;
+		size_t len;
+		bool result;
+
+		static void resume(void* address) { std::coroutine_handle<>::from_address(address).resume(); }
+	};
+#endif
+
+	// Runs remote reads and writes on a pool of I/O threads, so the submitting thread doesn't wait for them.
+	// Each I/O thread takes every queued request (up to ASYNC_BATCH_MAX) at once and issues consecutive reads
+	// as one RemoteBackend::readBatch and consecutive writes as one writeBatch, so the more requests are in
+	// flight, the fewer calls they cost.
+	// A request completes through a future, or through the completion queue if it was given a tag, or by
+	// resuming the coroutine awaiting it. Requests in flight at the same time may complete in any order.
+	// The backend is called from the I/O threads, with more than one of them it has to allow that
+	// (ProcessBackend and LocalBackend do, ViewBackend doesn't).
+	class AsyncIO {
+	public:
+		explicit AsyncIO(RemoteBackend* backend, size_t threads = ASYNC_DEFAULT_THREADS);
+
+		// Finishes every submitted request, then stops the I/O threads. Completions nobody polled are dropped.
+		~AsyncIO();
+
+		AsyncIO(const AsyncIO&) = delete;
+		AsyncIO& operator=(const AsyncIO&) = delete;
+
+		// Read len (remote) bytes into local_dst, which has to stay valid until the request is done.
+		std::future<bool> read(uint32_t rmt_src, void* local_dst, size_t len);
+
+		// Write len bytes to a (remote) address. The bytes are copied, local_src can go away right after.
+		std::future<bool> write(uint32_t rmt_dst, const void* local_src, size_t len);
+
+		// Read, completing through the completion queue with the given tag.
+		void submitRead(uint32_t rmt_src, void* local_dst, size_t len, uint64_t tag);
+
+		// Write, completing through the completion queue with the given tag.
+		void submitWrite(uint32_t rmt_dst, const void* local_src, size_t len, uint64_t tag);
+
+#ifdef ASYNC_COROUTINES
+		// co_await io.readAwait(addr, &value, sizeof(value)) reads without blocking the coroutine's thread.
+		AsyncAwaitable readAwait(uint32_t rmt_src, void* local_dst, size_t len) { return AsyncAwaitable(*this, ASYNC_READ, rmt_src, local_dst, 0, len); }
+
+		// co_await io.writeAwait(addr, &value, sizeof(value)).
+		AsyncAwaitable writeAwait(uint32_t rmt_dst, const void* local_src, size_t len) { return AsyncAwaitable(*this, ASYNC_WRITE, rmt_dst, 0, local_src, len); }
+#endif
+
+		// Take up to max_count completions off the completion queue without waiting, and resume coroutines
+		// whose request finished. Returns the number of completions written to out.
+		size_t poll(AsyncCompletion* out, size_t max_count);
+
+		// Same as poll, but waits up to timeout_ms for something to finish if nothing has.
+		size_t wait(AsyncCompletion* out, size_t max_count, DWORD timeout_ms);
+
+		// Wait until every submitted request has finished.
+		void drain();
+
+		// Requests submitted and not finished yet.
+		size_t inFlight() const { return in_flight; }
+
+		AsyncStats stats();
+
+	private:
+#ifdef ASYNC_COROUTINES
+		friend class AsyncAwaitable;
+#endif
+
+		enum Notify {
+			NOTIFY_FUTURE,
+			NOTIFY_QUEUE,
+			NOTIFY_RESUME
+		};
+
+		struct Request {
+			AsyncOp op;
+			uint32_t address;
+			size_t len;
+			void* local_dst;
+			std::vector<byte> data;       // Bytes to write.
+			Notify notify;
+			std::promise<bool> promise;
+			uint64_t tag;
+			void (*resume)(void*);        // Resumes the coroutine at resume_address.
+			void* resume_address;
+			bool* result;
+		};
+
+		struct Completion {
+			AsyncCompletion info;
+			void (*resume)(void*);        // 0 for tagged requests.
+			void* resume_address;
+		};
+
+		RemoteBackend* backend;
+		std::vector<std::thread> workers;
+		std::mutex queue_lock;
+		std::condition_variable queue_cond;
+		std::deque<Request> queue;
+		bool stopping;
+
+		std::mutex done_lock;
+		std::condition_variable done_cond;
+		std::deque<Completion> completions;
+		std::atomic<size_t> in_flight;
+
+		std::mutex stats_lock;
+		AsyncStats async_stats;
+
+		void submit(Request&& request);
+		void complete(Request& request, bool ok);
+		void run();
+	};
+
+#ifdef ASYNC_COROUTINES
+	inline void AsyncAwaitable::await_suspend(std::coroutine_handle<> handle) {
+		AsyncIO::Request request;
+		request.op = op;
+		request.address = address;
+		request.len = len;
+		request.local_dst = local;
+		if (op == ASYNC_WRITE)
+			request.data.assign(static_cast<const byte*>(local_src), static_cast<const byte*>(local_src) + len);
+		request.notify = AsyncIO::NOTIFY_RESUME;
+		request.tag = 0;
+		request.resume = &AsyncAwaitable::resume;
+		request.resume_address = handle.address();
+		request.result = &result;
+		io.submit(std::move(request));
+	}
+#endif
+}
\ No newline at end of file
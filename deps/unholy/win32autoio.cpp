@@ -0,0 +1,246 @@
+#include "win32autoio.hpp"
+#include "win32buffer.hpp"
+
+#include <map>
+#include <mutex>
+#include <vector>
+
+// Not in the SDK headers, loaded from ntdll.
+typedef LONG(NTAPI* NtReadVirtualMemory_t)(HANDLE, PVOID, PVOID, SIZE_T, PSIZE_T);
+typedef LONG(NTAPI* NtWriteVirtualMemory_t)(HANDLE, PVOID, PVOID, SIZE_T, PSIZE_T);
+
+// Crossover used until calibrate() measures one.
+#define IO_DEFAULT_NATIVE_MAX 0x1000
+
+static NtReadVirtualMemory_t ntReadVirtualMemory() {
+	static NtReadVirtualMemory_t func = reinterpret_cast<NtReadVirtualMemory_t>(GetProcAddress(GetModuleHandleA("ntdll.dll"), "NtReadVirtualMemory"));
+	return func;
+}
+
+static NtWriteVirtualMemory_t ntWriteVirtualMemory() {
+	static NtWriteVirtualMemory_t func = reinterpret_cast<NtWriteVirtualMemory_t>(GetProcAddress(GetModuleHandleA("ntdll.dll"), "NtWriteVirtualMemory"));
+	return func;
+}
+
+// Protection to temporarily give a region that can't be accessed as it is, or 0 if it doesn't need any.
+static DWORD accessibleProtection(DWORD protect, bool writing) {
+	DWORD base = protect & 0xFF;
+	bool exec = (base & PAGE_ANYEXECUTE) != 0;
+	if (writing)
+		return (base & PAGE_ANYWRITE) && !(protect & PAGE_GUARD) ? 0 : (exec ? PAGE_EXECUTE_READWRITE : PAGE_READWRITE);
+	if ((base & PAGE_ANYREAD) && !(protect & PAGE_GUARD))
+		return 0;
+	return exec ? PAGE_EXECUTE_READ : PAGE_READONLY;
+}
+
+// Copy to or from a process region by region, lifting the protection of regions that need it for the
+// duration of their copy.
+static bool protectedCopy(HANDLE rmt_handle, uint32_t rmt_addr, byte* local_buf, size_t len, bool writing) {
+	uint32_t end = rmt_addr + static_cast<uint32_t>(len);
+	while (rmt_addr < end) {
+		MEMORY_BASIC_INFORMATION mbi;
+		if (!VirtualQueryEx(rmt_handle, reinterpret_cast<void*>(rmt_addr), &mbi, sizeof(mbi)) || mbi.State != MEM_COMMIT)
+			return false;
+
+		uint32_t region_end = reinterpret_cast<uint32_t>(mbi.BaseAddress) + static_cast<uint32_t>(mbi.RegionSize);
+		size_t chunk = min(region_end, end) - rmt_addr;
+		void* rmt_ptr = reinterpret_cast<void*>(rmt_addr);
+		DWORD lifted = accessibleProtection(mbi.Protect, writing);
+		DWORD oldprot = 0;
+		if (lifted && !VirtualProtectEx(rmt_handle, rmt_ptr, chunk, lifted, &oldprot))
+			return false;
+
+		bool ok = writing ? WriteProcessMemory(rmt_handle, rmt_ptr, local_buf, chunk, 0) != 0 : ReadProcessMemory(rmt_handle, rmt_ptr, local_buf, chunk, 0) != 0;
+		if (lifted)
+			VirtualProtectEx(rmt_handle, rmt_ptr, chunk, oldprot, &oldprot);
+		if (!ok)
+			return false;
+
+		rmt_addr += static_cast<uint32_t>(chunk);
+		local_buf += chunk;
+	}
+	return true;
+}
+
+// ------------------------
+// HANDLE CACHE
+// ------------------------
+
+struct CachedHandle {
+	HANDLE handle;
+	DWORD access;
+};
+
+static std::mutex handle_lock;
+static std::map<uint32_t, CachedHandle> handle_cache;
+static std::vector<HANDLE> retired_handles;
+
+// SYNCHRONIZE is always asked for, it's what lets an exited process be noticed.
+// A reopen asks for the union of old and new access. The old handle was given out and may still be in
+// use, so it is kept open until closeCachedHandles() rather than closed (a closed handle's value can be
+// reused for something else).
+HANDLE Memory::Remote::cachedHandle(uint32_t pid, DWORD access) {
+	access |= SYNCHRONIZE;
+	std::lock_guard<std::mutex> lock(handle_lock);
+	auto it = handle_cache.find(pid);
+	if (it != handle_cache.end()) {
+		CachedHandle& cached = it->second;
+		if ((cached.access & access) == access && WaitForSingleObject(cached.handle, 0) == WAIT_TIMEOUT)
+			return cached.handle;
+
+		if (WaitForSingleObject(cached.handle, 0) == WAIT_TIMEOUT)
+			access |= cached.access;
+		retired_handles.push_back(cached.handle);
+		handle_cache.erase(it);
+	}
+
+	HANDLE handle = OpenProcess(access, FALSE, pid);
+	if (!handle)
+		return 0;
+	CachedHandle cached = { handle, access };
+	handle_cache[pid] = cached;
+	return handle;
+}
+
+void Memory::Remote::closeCachedHandles() {
+	std::lock_guard<std::mutex> lock(handle_lock);
+	for (auto it = handle_cache.begin(); it != handle_cache.end(); ++it)
+		CloseHandle(it->second.handle);
+	handle_cache.clear();
+	for (size_t i = 0; i < retired_handles.size(); i++)
+		CloseHandle(retired_handles[i]);
+	retired_handles.clear();
+}
+
+// ------------------------
+// AUTO BACKEND
+// ------------------------
+
+Memory::AutoBackend::AutoBackend(uint32_t pid, bool calibrate_now) : handle(Memory::Remote::cachedHandle(pid)) {
+	init(calibrate_now);
+}
+
+Memory::AutoBackend::AutoBackend(HANDLE rmt_handle, bool calibrate_now) : handle(rmt_handle) {
+	init(calibrate_now);
+}
+
+void Memory::AutoBackend::init(bool calibrate_now) {
+	native_ok = ntReadVirtualMemory() && ntWriteVirtualMemory();
+	protect_override = false;
+	memset(&calib, 0, sizeof(calib));
+	memset(&io_stats, 0, sizeof(io_stats));
+	calib.native_max = IO_DEFAULT_NATIVE_MAX;
+	for (size_t i = 0; i < IO_CALIBRATION_SIZES; i++)
+		calib.sizes[i] = static_cast<size_t>(4) << (i * 2);
+
+	if (calibrate_now && handle)
+		calibrate();
+}
+
+bool Memory::AutoBackend::transfer(IoPath path, uint32_t rmt_addr, void* local_buf, size_t len, bool writing) {
+	io_stats.calls[path]++;
+	bool ok;
+	if (path == IO_NATIVE) {
+		SIZE_T done = 0;
+		LONG status = writing ? ntWriteVirtualMemory()(handle, reinterpret_cast<void*>(rmt_addr), local_buf, len, &done)
+			: ntReadVirtualMemory()(handle, reinterpret_cast<void*>(rmt_addr), local_buf, len, &done);
+		ok = status >= 0 && done == len;
+	} else if (path == IO_WIN32) {
+		ok = writing ? WriteProcessMemory(handle, reinterpret_cast<void*>(rmt_addr), local_buf, len, 0) != 0
+			: ReadProcessMemory(handle, reinterpret_cast<void*>(rmt_addr), local_buf, len, 0) != 0;
+	} else {
+		ok = protectedCopy(handle, rmt_addr, static_cast<byte*>(local_buf), len, writing);
+	}
+
+	if (ok)
+		io_stats.bytes[path] += len;
+	return ok;
+}
+
+bool Memory::AutoBackend::read(uint32_t rmt_src, void* local_dst, size_t len) {
+	if (transfer(pathFor(len), rmt_src, local_dst, len, false) || (protect_override && transfer(IO_PROTECT, rmt_src, local_dst, len, false)))
+		return true;
+	io_stats.failures++;
+	return false;
+}
+
+bool Memory::AutoBackend::write(uint32_t rmt_dst, const void* local_src, size_t len) {
+	void* src = const_cast<void*>(local_src);
+	if (transfer(pathFor(len), rmt_dst, src, len, true) || (protect_override && transfer(IO_PROTECT, rmt_dst, src, len, true)))
+		return true;
+	io_stats.failures++;
+	return false;
+}
+
+// Batches already make few calls, so they always go through Memory::Remote::readBatch.
+size_t Memory::AutoBackend::readBatch(Memory::Remote::ReadEntry* entries, size_t count) {
+	io_stats.calls[IO_WIN32]++;
+	size_t read_count = Memory::Remote::readBatch(handle, entries, count);
+	for (size_t i = 0; i < count && read_count < count; i++) {
+		if (entries[i].ok)
+			continue;
+		entries[i].ok = protect_override && transfer(IO_PROTECT, reinterpret_cast<uint32_t>(entries[i].rmt_src), entries[i].local_dst, entries[i].len, false);
+		if (entries[i].ok)
+			read_count++;
+		else
+			io_stats.failures++;
+	}
+	return read_count;
+}
+
+// Every size is timed for both paths in a few rounds, keeping each path's best round so a context switch
+// doesn't skew it. The crossover is the last size before the Win32 path stops losing.
+bool Memory::AutoBackend::calibrate() {
+	size_t max_size = calib.sizes[IO_CALIBRATION_SIZES - 1];
+
+	// Find the largest readable region, the bigger sizes are skipped if it's smaller than them.
+	MEMORY_BASIC_INFORMATION mbi;
+	uint32_t rmt_src = 0;
+	size_t region_size = 0;
+	for (byte* addr = 0; VirtualQueryEx(handle, addr, &mbi, sizeof(mbi)) && region_size < max_size; addr = static_cast<byte*>(mbi.BaseAddress) + mbi.RegionSize) {
+		if (mbi.State == MEM_COMMIT && mbi.Protect & PAGE_ANYREAD && !(mbi.Protect & PAGE_GUARD) && mbi.RegionSize > region_size) {
+			rmt_src = reinterpret_cast<uint32_t>(mbi.BaseAddress);
+			region_size = mbi.RegionSize;
+		}
+	}
+
+	LocalBuffer local_dst(max_size);
+	LARGE_INTEGER freq;
+	if (!rmt_src || !local_dst || !QueryPerformanceFrequency(&freq))
+		return false;
+
+	IoStats saved = io_stats;
+	size_t path_count = native_ok ? IO_NATIVE + 1 : IO_WIN32 + 1;
+	for (size_t i = 0; i < IO_CALIBRATION_SIZES; i++) {
+		size_t size = calib.sizes[i];
+		if (size > region_size)
+			break;
+
+		size_t reps = min(static_cast<size_t>(2000), max(static_cast<size_t>(16), 0x400000 / size));
+		for (size_t path = 0; path < path_count; path++) {
+			double best = 0.0;
+			for (int round = 0; round < 3; round++) {
+				LARGE_INTEGER start, end;
+				QueryPerformanceCounter(&start);
+				for (size_t rep = 0; rep < reps; rep++)
+					transfer(static_cast<IoPath>(path), rmt_src, local_dst.data(), size, false);
+				QueryPerformanceCounter(&end);
+
+				double micros = static_cast<double>(end.QuadPart - start.QuadPart) * 1000000.0 / static_cast<double>(freq.QuadPart) / reps;
+				if (!round || micros < best)
+					best = micros;
+			}
+			calib.micros[path][i] = best;
+		}
+	}
+	io_stats = saved;
+
+	calib.native_max = 0;
+	for (size_t i = 0; native_ok && i < IO_CALIBRATION_SIZES && calib.sizes[i] <= region_size; i++) {
+		if (calib.micros[IO_NATIVE][i] >= calib.micros[IO_WIN32][i])
+			break;
+		calib.native_max = calib.sizes[i];
+	}
+	calib.done = true;
+	return true;
+}
\ No newline at end of file
@@ -0,0 +1,86 @@
+#pragma once
+#include <stdint.h>
+#include <Windows.h>
+
+#include "win32backend.hpp"
+
+// Transfer sizes the calibration times, powers of four from 4 bytes to 256KB.
+#define IO_CALIBRATION_SIZES  9
+
+namespace Memory {
+	// Ways an AutoBackend can move memory.
+	enum IoPath {
+		IO_WIN32,    // ReadProcessMemory / WriteProcessMemory.
+		IO_NATIVE,   // NtReadVirtualMemory / NtWriteVirtualMemory, skipping the kernel32 wrapper.
+		IO_PROTECT,  // Protection lifted with VirtualProtectEx around the copy, for PAGE_NOACCESS / PAGE_GUARD memory.
+		IO_PATHS
+	};
+
+	// Calibration results of an AutoBackend.
+	struct IoCalibration {
+		size_t sizes[IO_CALIBRATION_SIZES];
+		double micros[IO_NATIVE + 1][IO_CALIBRATION_SIZES];  // Average time per transfer, per path and size.
+		size_t native_max;  // Transfers up to this size use IO_NATIVE, 0 if it never won.
+		bool done;
+	};
+
+	// Counters of an AutoBackend.
+	struct IoStats {
+		uint64_t calls[IO_PATHS];
+		uint64_t bytes[IO_PATHS];
+		uint64_t failures;
+	};
+
+	namespace Remote {
+		// Handle to a process, opened once and shared by everything that asks for the same pid.
+		// The handle is reopened if it lacks access or its process has exited. Handles given out stay open
+		// until closeCachedHandles(), even once superseded. Don't close them.
+		// Returns 0 if the process can't be opened.
+		HANDLE cachedHandle(uint32_t pid, DWORD access = PROCESS_VM_READ | PROCESS_VM_WRITE | PROCESS_VM_OPERATION | PROCESS_QUERY_INFORMATION);
+
+		// Close every cached handle, including superseded ones. Nothing may use them after this.
+		void closeCachedHandles();
+	}
+
+	// Backend that picks the fastest way to access a process for each call.
+	// Small transfers go through the native API directly, which saves the wrapper's overhead, larger
+	// ones through the Win32 functions; where the two cross over is measured by calibrate(). Memory that
+	// can't be accessed because of its protection is retried with the protection lifted, if allowed.
+	class AutoBackend : public RemoteBackend {
+	public:
+		// Use the cached handle of a process (see Memory::Remote::cachedHandle).
+		explicit AutoBackend(uint32_t pid, bool calibrate_now = true);
+
+		// Use a handle, which must stay open while the backend is in use.
+		explicit AutoBackend(HANDLE rmt_handle, bool calibrate_now = true);
+
+		bool read(uint32_t rmt_src, void* local_dst, size_t len);
+		bool write(uint32_t rmt_dst, const void* local_src, size_t len);
+		size_t readBatch(Memory::Remote::ReadEntry* entries, size_t count);
+
+		// Time both paths on readable memory of the process and set the crossover size.
+		// Writes use the same crossover, calibrating them would mean writing to the process.
+		// Returns false if no readable memory was found, the defaults stay in place then.
+		bool calibrate();
+
+		// Allow lifting page protection for memory that can't be accessed otherwise. Off by default.
+		void setProtectOverride(bool allow) { protect_override = allow; }
+
+		// Path a transfer of len bytes takes, unless protection gets in the way.
+		IoPath pathFor(size_t len) const { return native_ok && len <= calib.native_max ? IO_NATIVE : IO_WIN32; }
+
+		HANDLE processHandle() const { return handle; }
+		const IoCalibration& calibration() const { return calib; }
+		const IoStats& stats() const { return io_stats; }
+
+	private:
+		HANDLE handle;
+		bool native_ok;
+		bool protect_override;
+		IoCalibration calib;
+		IoStats io_stats;
+
+		void init(bool calibrate_now);
+		bool transfer(IoPath path, uint32_t rmt_addr, void* local_buf, size_t len, bool writing);
+	};
+}
\ No newline at end of file
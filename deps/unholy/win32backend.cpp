@@ -0,0 +1,73 @@
+#include "win32backend.hpp"
+
+size_t Memory::RemoteBackend::readBatch(Memory::Remote::ReadEntry* entries, size_t count) {
+	size_t read_count = 0;
+	for (size_t i = 0; i < count; i++) {
+		entries[i].ok = read(reinterpret_cast<uint32_t>(entries[i].rmt_src), entries[i].local_dst, entries[i].len);
+		if (entries[i].ok)
+			read_count++;
+	}
+	return read_count;
+}
+
+size_t Memory::RemoteBackend::writeBatch(Memory::Remote::WriteEntry* entries, size_t count) {
+	size_t write_count = 0;
+	for (size_t i = 0; i < count; i++) {
+		entries[i].ok = write(reinterpret_cast<uint32_t>(entries[i].rmt_dst), entries[i].local_src, entries[i].len);
+		if (entries[i].ok)
+			write_count++;
+	}
+	return write_count;
+}
+
+// ------------------------
+// PROCESS BACKEND
+// ------------------------
+
+bool Memory::ProcessBackend::read(uint32_t rmt_src, void* local_dst, size_t len) {
+	return ReadProcessMemory(handle, reinterpret_cast<void*>(rmt_src), local_dst, len, 0) != 0;
+}
+
+bool Memory::ProcessBackend::write(uint32_t rmt_dst, const void* local_src, size_t len) {
+	return WriteProcessMemory(handle, reinterpret_cast<void*>(rmt_dst), local_src, len, 0) != 0;
+}
+
+size_t Memory::ProcessBackend::readBatch(Memory::Remote::ReadEntry* entries, size_t count) {
+	return Memory::Remote::readBatch(handle, entries, count);
+}
+
+size_t Memory::ProcessBackend::writeBatch(Memory::Remote::WriteEntry* entries, size_t count) {
+	Memory::Remote::WriteBatch batch(handle);
+	for (size_t i = 0; i < count; i++)
+		batch.add(entries[i].rmt_dst, entries[i].local_src, entries[i].len);
+	size_t write_count = batch.commit();
+	for (size_t i = 0; i < count; i++)
+		entries[i].ok = batch.ok(i);
+	return write_count;
+}
+
+// ------------------------
+// LOCAL BACKEND
+// ------------------------
+
+bool Memory::LocalBackend::read(uint32_t rmt_src, void* local_dst, size_t len) {
+	memcpy(local_dst, reinterpret_cast<const void*>(rmt_src), len);
+	return true;
+}
+
+bool Memory::LocalBackend::write(uint32_t rmt_dst, const void* local_src, size_t len) {
+	memcpy(reinterpret_cast<void*>(rmt_dst), local_src, len);
+	return true;
+}
+
+// ------------------------
+// VIEW BACKEND
+// ------------------------
+
+bool Memory::ViewBackend::read(uint32_t rmt_src, void* local_dst, size_t len) {
+	return view.read(reinterpret_cast<const void*>(rmt_src), local_dst, len);
+}
+
+bool Memory::ViewBackend::write(uint32_t rmt_dst, const void* local_src, size_t len) {
+	return view.write(reinterpret_cast<void*>(rmt_dst), local_src, len);
+}
\ No newline at end of file
@@ -0,0 +1,68 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <Windows.h>
+
+#include "win32memory.hpp"
+#include "win32view.hpp"
+
+namespace Memory {
+	// Where remote memory is read from and written to.
+	// Lets the same reading code run against a process, a cached view of one or the current process.
+	class RemoteBackend {
+	public:
+		virtual ~RemoteBackend() {}
+
+		// Read len bytes at a (remote) address. Returns false if any of it couldn't be read.
+		virtual bool read(uint32_t rmt_src, void* local_dst, size_t len) = 0;
+
+		// Write len bytes to a (remote) address. Returns false if any of it couldn't be written.
+		virtual bool write(uint32_t rmt_dst, const void* local_src, size_t len) = 0;
+
+		// Read many ranges, setting ok on each entry. Returns the number of entries read.
+		// Reads one entry at a time unless the backend can do better.
+		virtual size_t readBatch(Memory::Remote::ReadEntry* entries, size_t count);
+
+		// Write many ranges in order, setting ok on each entry. Returns the number of entries written.
+		// Writes one entry at a time unless the backend can do better.
+		virtual size_t writeBatch(Memory::Remote::WriteEntry* entries, size_t count);
+	};
+
+	// Backend for a process handle, using ReadProcessMemory / WriteProcessMemory.
+	class ProcessBackend : public RemoteBackend {
+	public:
+		explicit ProcessBackend(HANDLE rmt_handle) : handle(rmt_handle) {}
+
+		bool read(uint32_t rmt_src, void* local_dst, size_t len);
+		bool write(uint32_t rmt_dst, const void* local_src, size_t len);
+		size_t readBatch(Memory::Remote::ReadEntry* entries, size_t count);
+
+		// Goes through a Memory::Remote::WriteBatch, which also makes read-only pages writable for the write.
+		size_t writeBatch(Memory::Remote::WriteEntry* entries, size_t count);
+
+		HANDLE processHandle() const { return handle; }
+
+	private:
+		HANDLE handle;
+	};
+
+	// Backend for the current process, reads and writes are plain memcpy calls.
+	// There is no checking, every address passed to it must be valid.
+	class LocalBackend : public RemoteBackend {
+	public:
+		bool read(uint32_t rmt_src, void* local_dst, size_t len);
+		bool write(uint32_t rmt_dst, const void* local_src, size_t len);
+	};
+
+	// Backend reading through a RemoteMemoryView.
+	class ViewBackend : public RemoteBackend {
+	public:
+		explicit ViewBackend(RemoteMemoryView& view) : view(view) {}
+
+		bool read(uint32_t rmt_src, void* local_dst, size_t len);
+		bool write(uint32_t rmt_dst, const void* local_src, size_t len);
+
+	private:
+		RemoteMemoryView& view;
+	};
+}
\ No newline at end of file
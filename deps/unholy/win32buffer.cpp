@@ -0,0 +1,206 @@
+#include "win32buffer.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Buffers smaller than this are carved out of slabs of this size, bigger ones get a VirtualAlloc each.
+#define BUFFER_SLAB_SIZE 0x10000
+
+// Free buffers shared by all threads.
+struct SharedPool {
+	std::mutex locks[BUFFER_CLASSES];
+	std::vector<byte*> free_lists[BUFFER_CLASSES];
+	std::atomic<uint64_t> acquires;
+	std::atomic<uint64_t> cache_hits;
+	std::atomic<uint64_t> pool_hits;
+	std::atomic<uint64_t> allocations;
+	std::atomic<uint64_t> reserved;
+};
+
+// Never destroyed, threads can still give their caches back during process exit.
+static SharedPool& sharedPool() {
+	static SharedPool* pool = new SharedPool();
+	return *pool;
+}
+
+static size_t classSize(size_t cls) {
+	return static_cast<size_t>(BUFFER_MIN_CLASS) << cls;
+}
+
+static size_t cacheLimit(size_t cls) {
+	return max(static_cast<size_t>(1), min(static_cast<size_t>(BUFFER_CACHE_LIMIT), BUFFER_CACHE_BYTES / classSize(cls)));
+}
+
+// Buffers a thread keeps for itself, given back to the shared pool when the thread exits.
+struct ThreadCache {
+	std::vector<byte*> free_lists[BUFFER_CLASSES];
+
+	~ThreadCache() {
+		SharedPool& pool = sharedPool();
+		for (size_t cls = 0; cls < BUFFER_CLASSES; cls++) {
+			std::lock_guard<std::mutex> lock(pool.locks[cls]);
+			pool.free_lists[cls].insert(pool.free_lists[cls].end(), free_lists[cls].begin(), free_lists[cls].end());
+		}
+	}
+};
+
+static thread_local ThreadCache thread_cache;
+
+// Size class fitting len bytes, or BUFFER_CLASSES if it's too big for one.
+static size_t bufferClass(size_t len) {
+	size_t cls = 0;
+	while (cls < BUFFER_CLASSES && classSize(cls) < len)
+		cls++;
+	return cls;
+}
+
+// Refill a thread's cache of a class from the shared pool, half of its limit at a time,
+// allocating new buffers if the pool is out.
+static bool refill(std::vector<byte*>& cache, size_t cls) {
+	SharedPool& pool = sharedPool();
+	size_t want = max(static_cast<size_t>(1), cacheLimit(cls) / 2);
+	{
+		std::lock_guard<std::mutex> lock(pool.locks[cls]);
+		std::vector<byte*>& list = pool.free_lists[cls];
+		size_t take = min(want, list.size());
+		cache.insert(cache.end(), list.end() - take, list.end());
+		list.resize(list.size() - take);
+	}
+	if (!cache.empty()) {
+		pool.pool_hits++;
+		return true;
+	}
+
+	size_t size = classSize(cls);
+	size_t slab_size = max(size, static_cast<size_t>(BUFFER_SLAB_SIZE));
+	byte* slab = static_cast<byte*>(VirtualAlloc(0, slab_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+	if (!slab)
+		return false;
+	pool.allocations++;
+	pool.reserved += slab_size;
+
+	// Only part of a slab of small buffers goes into the cache, the rest is shared.
+	size_t count = slab_size / size;
+	size_t keep = min(count, want);
+	for (size_t i = 0; i < keep; i++)
+		cache.push_back(slab + i * size);
+	if (count > keep) {
+		std::lock_guard<std::mutex> lock(pool.locks[cls]);
+		for (size_t i = keep; i < count; i++)
+			pool.free_lists[cls].push_back(slab + i * size);
+	}
+	return true;
+}
+
+// ------------------------
+// BUFFER POOL
+// ------------------------
+
+byte* Memory::BufferPool::acquire(size_t len, size_t& capacity) {
+	SharedPool& pool = sharedPool();
+	pool.acquires++;
+	size_t cls = bufferClass(max(len, static_cast<size_t>(1)));
+	if (cls == BUFFER_CLASSES) {
+		capacity = len;
+		return static_cast<byte*>(VirtualAlloc(0, len, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+	}
+
+	std::vector<byte*>& cache = thread_cache.free_lists[cls];
+	if (!cache.empty())
+		pool.cache_hits++;
+	else if (!refill(cache, cls))
+		return 0;
+
+	byte* buf = cache.back();
+	cache.pop_back();
+	capacity = classSize(cls);
+	return buf;
+}
+
+// A full cache hands half of its buffers back to the shared pool in one go.
+void Memory::BufferPool::release(byte* buf, size_t capacity) {
+	if (!buf)
+		return;
+
+	size_t cls = bufferClass(capacity);
+	if (cls == BUFFER_CLASSES || classSize(cls) != capacity) {
+		VirtualFree(buf, 0, MEM_RELEASE);
+		return;
+	}
+
+	std::vector<byte*>& cache = thread_cache.free_lists[cls];
+	cache.push_back(buf);
+	size_t limit = cacheLimit(cls);
+	if (cache.size() > limit) {
+		SharedPool& pool = sharedPool();
+		size_t give = cache.size() - limit / 2;
+		std::lock_guard<std::mutex> lock(pool.locks[cls]);
+		pool.free_lists[cls].insert(pool.free_lists[cls].end(), cache.end() - give, cache.end());
+		cache.resize(cache.size() - give);
+	}
+}
+
+Memory::BufferStats Memory::BufferPool::stats() {
+	SharedPool& pool = sharedPool();
+	BufferStats s;
+	s.acquires = pool.acquires;
+	s.cache_hits = pool.cache_hits;
+	s.pool_hits = pool.pool_hits;
+	s.allocations = pool.allocations;
+	s.reserved = pool.reserved;
+	return s;
+}
+
+// ------------------------
+// LOCAL BUFFER
+// ------------------------
+
+bool Memory::LocalBuffer::resize(size_t new_len) {
+	if (buf && new_len <= cap) {
+		len = new_len;
+		return true;
+	}
+
+	LocalBuffer bigger(new_len);
+	if (!bigger)
+		return false;
+	if (buf)
+		memcpy(bigger.buf, buf, len);
+	*this = std::move(bigger);
+	return true;
+}
+
+// ------------------------
+// REMOTE
+// ------------------------
+
+Memory::LocalBuffer Memory::Remote::readBuffer(HANDLE rmt_handle, const void* rmt_src, size_t len) {
+	LocalBuffer local_dst(len);
+	if (local_dst && !ReadProcessMemory(rmt_handle, rmt_src, local_dst.data(), len, 0))
+		local_dst.reset();
+	return local_dst;
+}
+
+// Read up to the end of a page at a time, so a string near the end of a region can still be read.
+Memory::LocalBuffer Memory::Remote::readStringBuffer(HANDLE rmt_handle, const void* rmt_src, size_t max_len) {
+	LocalBuffer local_dst(min(max_len, static_cast<size_t>(0x100)));
+	size_t read = 0;
+	while (local_dst && read < max_len) {
+		uint32_t addr = reinterpret_cast<uint32_t>(rmt_src) + static_cast<uint32_t>(read);
+		size_t chunk = min(0x1000 - (addr & 0xFFF), max_len - read);
+		if (!local_dst.resize(read + chunk) || !ReadProcessMemory(rmt_handle, reinterpret_cast<void*>(addr), local_dst.data() + read, chunk, 0))
+			break;
+
+		byte* end = static_cast<byte*>(memchr(local_dst.data() + read, 0, chunk));
+		if (end) {
+			local_dst.resize(end - local_dst.data() + 1);
+			return local_dst;
+		}
+		read += chunk;
+	}
+
+	local_dst.reset();
+	return local_dst;
+}
\ No newline at end of file
@@ -0,0 +1,112 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <Windows.h>
+
+// Size classes of pooled local buffers, powers of two from BUFFER_MIN_CLASS (64 bytes) to 2MB, so scan
+// chunks fit in one. Bigger buffers are allocated and freed directly.
+#define BUFFER_MIN_CLASS    64
+#define BUFFER_CLASSES      16
+
+// Buffers of one size class a thread keeps for itself before handing them back to the shared pool,
+// at most BUFFER_CACHE_LIMIT and at most BUFFER_CACHE_BYTES worth (but always one).
+#define BUFFER_CACHE_LIMIT  16
+#define BUFFER_CACHE_BYTES  0x100000
+
+namespace Memory {
+	// Counters of the buffer pool, totals over all threads.
+	struct BufferStats {
+		uint64_t acquires;      // Buffers handed out.
+		uint64_t cache_hits;    // Of those, taken from the calling thread's own cache.
+		uint64_t pool_hits;     // Of those, taken from the shared pool.
+		uint64_t allocations;   // VirtualAlloc calls made for new buffers.
+		uint64_t reserved;      // Bytes allocated for pooled buffers.
+	};
+
+	// Process wide pool of local buffers, in size classes.
+	// Each thread keeps a small cache per class so most acquires and releases don't take a lock, and the
+	// memory of pooled buffers is kept for reuse rather than freed.
+	class BufferPool {
+	public:
+		// Get a buffer of at least len bytes. capacity receives its actual size. Returns 0 if out of memory.
+		static byte* acquire(size_t len, size_t& capacity);
+
+		// Give back a buffer from acquire.
+		static void release(byte* buf, size_t capacity);
+
+		static BufferStats stats();
+	};
+
+	// Move-only handle to a pooled local buffer, given back to the pool when the handle goes away.
+	class LocalBuffer {
+	public:
+		LocalBuffer() : buf(0), len(0), cap(0) {}
+		explicit LocalBuffer(size_t len) : len(len) { buf = BufferPool::acquire(len, cap); if (!buf) this->len = 0; }
+		~LocalBuffer() { reset(); }
+
+		LocalBuffer(LocalBuffer&& other) : buf(other.buf), len(other.len), cap(other.cap) {
+			other.buf = 0;
+			other.len = 0;
+			other.cap = 0;
+		}
+
+		LocalBuffer& operator=(LocalBuffer&& other) {
+			if (this != &other) {
+				reset();
+				buf = other.buf;
+				len = other.len;
+				cap = other.cap;
+				other.buf = 0;
+				other.len = 0;
+				other.cap = 0;
+			}
+			return *this;
+		}
+
+		LocalBuffer(const LocalBuffer&) = delete;
+		LocalBuffer& operator=(const LocalBuffer&) = delete;
+
+		byte* data() const { return buf; }
+		size_t size() const { return len; }
+		size_t capacity() const { return cap; }
+		explicit operator bool() const { return buf != 0; }
+
+		// The buffer as a T*.
+		template <typename T>
+		inline T* as() const { return reinterpret_cast<T*>(buf); }
+
+		// Copy a T out of the buffer at a byte offset.
+		template <typename T>
+		inline T get(size_t offset = 0) const {
+			T value;
+			memcpy(&value, buf + offset, sizeof(T));
+			return value;
+		}
+
+		// Change the size, keeping the contents. Returns false if a bigger buffer couldn't be had.
+		bool resize(size_t new_len);
+
+		// Give the buffer back now.
+		void reset() {
+			if (buf)
+				BufferPool::release(buf, cap);
+			buf = 0;
+			len = 0;
+			cap = 0;
+		}
+
+	private:
+		byte* buf;
+		size_t len;
+		size_t cap;
+	};
+
+	namespace Remote {
+		// Read bytes from remote process into a pooled local buffer. The buffer is empty if the read failed.
+		LocalBuffer readBuffer(HANDLE rmt_handle, const void* rmt_src, size_t len);
+
+		// Read a string from remote process into a pooled local buffer, including its terminator.
+		// At most max_len bytes are read. The buffer is empty if no terminator could be found.
+		LocalBuffer readStringBuffer(HANDLE rmt_handle, const void* rmt_src, size_t max_len = 0x10000);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,164 @@
+#include "win32chain.hpp"
+
+#include <stdlib.h>
+
+// Parent of first level nodes.
+#define CHAIN_ROOT UINT32_MAX
+
+// Parse a hex number, with or without 0x. Returns false if there is none.
+static bool parseHex(const char*& expr, uint32_t& value) {
+	while (*expr == ' ')
+		expr++;
+	if (expr[0] == '0' && (expr[1] == 'x' || expr[1] == 'X'))
+		expr += 2;
+
+	char* end;
+	value = static_cast<uint32_t>(strtoul(expr, &end, 16));
+	if (end == expr)
+		return false;
+	expr = end;
+	return true;
+}
+
+// ------------------------
+// CHAIN RESOLVER
+// ------------------------
+
+Memory::ChainResolver::ChainResolver(RemoteBackend* backend) : backend(backend) {}
+
+size_t Memory::ChainResolver::add(uint32_t base, const uint32_t* offsets, size_t count, uint32_t final_offset) {
+	Chain chain = { CHAIN_ROOT, count ? final_offset : base + final_offset };
+	uint32_t parent = CHAIN_ROOT;
+	for (size_t i = 0; i < count; i++) {
+		// The base is folded into the first offset, so chains from different bases to the same pointer share it too.
+		std::pair<uint32_t, uint32_t> key(parent, i ? offsets[i] : base + offsets[i]);
+		auto it = node_index.find(key);
+		if (it == node_index.end()) {
+			Node node = { key.first, key.second, 0, false };
+			tree.push_back(node);
+			if (levels.size() <= i)
+				levels.resize(i + 1);
+			levels[i].push_back(static_cast<uint32_t>(tree.size() - 1));
+			it = node_index.insert(std::make_pair(key, static_cast<uint32_t>(tree.size() - 1))).first;
+		}
+		parent = it->second;
+	}
+
+	chain.leaf = parent;
+	chains.push_back(chain);
+	return chains.size() - 1;
+}
+
+size_t Memory::ChainResolver::add(uint32_t base, const std::vector<uint32_t>& offsets, uint32_t final_offset) {
+	return add(base, offsets.empty() ? 0 : &offsets[0], offsets.size(), final_offset);
+}
+
+// The number of leading brackets is the number of reads. After the base, offsets are summed up until a
+// closing bracket ends a read, whatever is summed after the last one is the final offset.
+size_t Memory::ChainResolver::add(const char* expr) {
+	size_t reads_left = 0;
+	while (*expr == '[' || *expr == ' ') {
+		if (*expr == '[')
+			reads_left++;
+		expr++;
+	}
+
+	uint32_t base;
+	if (!parseHex(expr, base))
+		return CHAIN_INVALID;
+
+	std::vector<uint32_t> offsets;
+	uint32_t sum = 0;
+	for (;;) {
+		while (*expr == ' ')
+			expr++;
+		if (!*expr)
+			break;
+
+		if (*expr == ']') {
+			if (!reads_left)
+				return CHAIN_INVALID;
+			reads_left--;
+			offsets.push_back(sum);
+			sum = 0;
+			expr++;
+		} else if (*expr == '+' || *expr == '-') {
+			bool negative = *expr++ == '-';
+			uint32_t value;
+			if (!parseHex(expr, value))
+				return CHAIN_INVALID;
+			sum += negative ? 0 - value : value;
+		} else {
+			return CHAIN_INVALID;
+		}
+	}
+
+	if (reads_left)
+		return CHAIN_INVALID;
+	if (offsets.empty())
+		return add(base, 0, 0, sum);
+	return add(base, offsets, sum);
+}
+
+void Memory::ChainResolver::clear() {
+	tree.clear();
+	levels.clear();
+	node_index.clear();
+	chains.clear();
+}
+
+// Pointers read as 0 count as failed, nothing below them gets read.
+size_t Memory::ChainResolver::resolve(size_t keep_levels) {
+	for (size_t level = 0; level < levels.size(); level++) {
+		const std::vector<uint32_t>& level_nodes = levels[level];
+		reads.clear();
+		for (size_t i = 0; i < level_nodes.size(); i++) {
+			Node& node = tree[level_nodes[i]];
+			if (level < keep_levels && node.ok)
+				continue;
+
+			node.ok = false;
+			uint32_t parent_value = 0;
+			if (node.parent != CHAIN_ROOT) {
+				const Node& parent = tree[node.parent];
+				if (!parent.ok)
+					continue;
+				parent_value = parent.value;
+			}
+
+			Memory::Remote::ReadEntry entry = { reinterpret_cast<void*>(parent_value + node.offset), sizeof(uint32_t), &node.value, false };
+			reads.push_back(entry);
+		}
+
+		if (reads.empty())
+			continue;
+		backend->readBatch(&reads[0], reads.size());
+
+		// Entries were added in node order, match them back up.
+		size_t entry = 0;
+		for (size_t i = 0; i < level_nodes.size() && entry < reads.size(); i++) {
+			Node& node = tree[level_nodes[i]];
+			if (reads[entry].local_dst != &node.value)
+				continue;
+			node.ok = reads[entry].ok && node.value != 0;
+			entry++;
+		}
+	}
+
+	size_t resolved = 0;
+	for (size_t i = 0; i < chains.size(); i++)
+		if (address(i))
+			resolved++;
+	return resolved;
+}
+
+uint32_t Memory::ChainResolver::address(size_t chain) const {
+	if (chain >= chains.size())
+		return 0;
+
+	const Chain& c = chains[chain];
+	if (c.leaf == CHAIN_ROOT)
+		return c.final_offset;
+	const Node& leaf = tree[c.leaf];
+	return leaf.ok ? leaf.value + c.final_offset : 0;
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+#include <stdint.h>
+#include <Windows.h>
+#include <map>
+#include <vector>
+
+#include "win32backend.hpp"
+#include "win32remoteptr.hpp"
+
+// Returned by ChainResolver::add when a chain couldn't be added.
+#define CHAIN_INVALID static_cast<size_t>(-1)
+
+namespace Memory {
+	// Resolves many pointer chains like [[[base+0x10]+0x48]+0x8] together.
+	// Chains are compiled into a tree where chains with the same start share nodes, and resolved level by
+	// level with one RemoteBackend::readBatch per level, so any number of chains of depth D costs D batches.
+	class ChainResolver {
+	public:
+		explicit ChainResolver(RemoteBackend* backend);
+
+		// Add a chain: read a pointer at base + offsets[0], then at that + offsets[1] and so on,
+		// and add final_offset to the last pointer read. Returns the index of the chain.
+		size_t add(uint32_t base, const uint32_t* offsets, size_t count, uint32_t final_offset = 0);
+
+		// Add a chain, see above.
+		size_t add(uint32_t base, const std::vector<uint32_t>& offsets, uint32_t final_offset = 0);
+
+		// Add a chain written as an expression of hex numbers, brackets are reads.
+		// E.g. "[[[401000+10]+48]+8]" or "[[0x401000+0x10]+0x48]+0x8".
+		// Returns CHAIN_INVALID if the expression can't be parsed.
+		size_t add(const char* expr);
+
+		// Remove every chain.
+		void clear();
+
+		// Resolve every chain. Returns the number of chains that resolved.
+		// Levels below keep_levels reuse the pointers read by the last resolve, if those were good; use it
+		// for the first levels of chains that start at static pointers which rarely change.
+		size_t resolve(size_t keep_levels = 0);
+
+		// Address a chain resolved to in the last resolve, or 0 if it didn't.
+		uint32_t address(size_t chain) const;
+
+		// Whether a chain resolved in the last resolve.
+		bool ok(size_t chain) const { return address(chain) != 0; }
+
+		// Typed pointer to what a chain resolved to.
+		template <typename T>
+		RemotePtr<T> ptr(size_t chain) const { return RemotePtr<T>(backend, address(chain)); }
+
+		// Number of chains.
+		size_t size() const { return chains.size(); }
+
+		// Number of distinct pointers read per resolve (chains share reads of common prefixes).
+		size_t nodes() const { return tree.size(); }
+
+		// Number of levels, i.e. readBatch calls a full resolve makes.
+		size_t depth() const { return levels.size(); }
+
+	private:
+		// One pointer read. It is read at (parent's pointer, or 0 for the first level) + offset.
+		struct Node {
+			uint32_t parent;
+			uint32_t offset;
+			uint32_t value;
+			bool ok;
+		};
+
+		// A chain ends at a node (or none, if it has no reads) plus a final offset.
+		struct Chain {
+			uint32_t leaf;
+			uint32_t final_offset;
+		};
+
+		RemoteBackend* backend;
+		std::vector<Node> tree;
+		std::vector<std::vector<uint32_t>> levels;      // Node indices by depth.
+		std::map<std::pair<uint32_t, uint32_t>, uint32_t> node_index;  // (parent, offset) -> node.
+		std::vector<Chain> chains;
+		std::vector<Memory::Remote::ReadEntry> reads;
+	};
+}
\ No newline at end of file
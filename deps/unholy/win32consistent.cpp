@@ -0,0 +1,133 @@
+#include "win32consistent.hpp"
+
+#include <thread>
+
+// ------------------------
+// CONSISTENT READER
+// ------------------------
+
+Memory::ConsistentReader::ConsistentReader(RemoteBackend* backend, uint32_t max_retries) : backend(backend), max_retries(max_retries) {
+	resetStats();
+}
+
+bool Memory::ConsistentReader::read(uint32_t rmt_src, void* local_dst, size_t len) {
+	ConsistentEntry entry = { rmt_src, len, local_dst, false, 0, false, false, 0 };
+	return readBatch(&entry, 1) == 1;
+}
+
+bool Memory::ConsistentReader::readVersioned(uint32_t rmt_src, void* local_dst, size_t len, int32_t version_offset, bool seqlock) {
+	ConsistentEntry entry = { rmt_src, len, local_dst, true, version_offset, seqlock, false, 0 };
+	return readBatch(&entry, 1) == 1;
+}
+
+// Every round reads all ranges still pending in three steps, each one readBatch: the version fields,
+// the ranges, the version fields again. The steps are separate calls so they happen in that order
+// (a single readBatch may merge overlapping reads into one copy).
+// Plain ranges are read into local_dst the first round and into scratch after, a range is done once its
+// scratch copy matches local_dst, otherwise the newer read replaces it and the range goes another round.
+// Ranges that can't be read at all aren't retried.
+size_t Memory::ConsistentReader::readBatch(ConsistentEntry* entries, size_t count) {
+	pending.clear();
+	scratch_offsets.resize(count);
+	size_t scratch_len = 0;
+	for (size_t i = 0; i < count; i++) {
+		entries[i].ok = false;
+		entries[i].attempts = 0;
+		pending.push_back(i);
+		if (!entries[i].versioned) {
+			scratch_offsets[i] = scratch_len;
+			scratch_len += entries[i].len;
+		}
+	}
+	scratch.resize(max(scratch_len, static_cast<size_t>(1)));
+	versions.resize(count * 2);
+	consistent_stats.reads += count;
+
+	size_t consistent = 0;
+	std::vector<size_t> next;
+	for (size_t round = 0; !pending.empty(); round++) {
+		// Give the writer a moment to finish before trying again.
+		if (round)
+			std::this_thread::yield();
+
+		version_reads.clear();
+		for (size_t p = 0; p < pending.size(); p++) {
+			ConsistentEntry& e = entries[pending[p]];
+			if (e.versioned) {
+				Memory::Remote::ReadEntry read = { reinterpret_cast<void*>(e.rmt_src + e.version_offset), sizeof(uint32_t), &versions[pending[p] * 2], false };
+				version_reads.push_back(read);
+			}
+		}
+		size_t version_count = version_reads.size();
+		if (version_count)
+			backend->readBatch(&version_reads[0], version_count);
+
+		reads.clear();
+		for (size_t p = 0; p < pending.size(); p++) {
+			ConsistentEntry& e = entries[pending[p]];
+			void* dst = !e.versioned && e.attempts ? &scratch[scratch_offsets[pending[p]]] : e.local_dst;
+			Memory::Remote::ReadEntry read = { reinterpret_cast<void*>(e.rmt_src), e.len, dst, false };
+			reads.push_back(read);
+		}
+		backend->readBatch(&reads[0], reads.size());
+
+		for (size_t p = 0; p < pending.size(); p++) {
+			ConsistentEntry& e = entries[pending[p]];
+			if (e.versioned) {
+				Memory::Remote::ReadEntry read = { reinterpret_cast<void*>(e.rmt_src + e.version_offset), sizeof(uint32_t), &versions[pending[p] * 2 + 1], false };
+				version_reads.push_back(read);
+			}
+		}
+		if (version_count)
+			backend->readBatch(&version_reads[version_count], version_count);
+
+		next.clear();
+		size_t v = 0;
+		for (size_t p = 0; p < pending.size(); p++) {
+			size_t idx = pending[p];
+			ConsistentEntry& e = entries[idx];
+			e.attempts++;
+			bool read_ok = reads[p].ok;
+			if (e.versioned) {
+				read_ok = read_ok && version_reads[v].ok && version_reads[version_count + v].ok;
+				v++;
+			}
+			if (!read_ok) {
+				consistent_stats.failed++;
+				continue;
+			}
+
+			bool same;
+			uint32_t fewest = e.versioned ? 1 : 2;
+			if (e.versioned) {
+				uint32_t before = versions[idx * 2];
+				same = before == versions[idx * 2 + 1] && !(e.seqlock && (before & 1));
+			} else if (e.attempts == 1) {
+				next.push_back(idx);
+				continue;
+			} else {
+				const byte* latest = &scratch[scratch_offsets[idx]];
+				same = !memcmp(latest, e.local_dst, e.len);
+				if (!same)
+					memcpy(e.local_dst, latest, e.len);
+			}
+
+			if (same || e.attempts >= fewest + max_retries) {
+				e.ok = same;
+				consistent_stats.retries += e.attempts - fewest;
+				consistent_stats.max_attempts = max(consistent_stats.max_attempts, e.attempts);
+				if (e.attempts > fewest)
+					consistent_stats.torn++;
+				if (same)
+					consistent++;
+				else
+					consistent_stats.gave_up++;
+				continue;
+			}
+			next.push_back(idx);
+		}
+		pending.swap(next);
+	}
+
+	return consistent;
+}
\ No newline at end of file
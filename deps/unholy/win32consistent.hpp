@@ -0,0 +1,89 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <Windows.h>
+#include <vector>
+
+#include "win32backend.hpp"
+
+// Extra reads a ConsistentReader tries before giving up on a range.
+#define CONSISTENT_MAX_RETRIES  8
+
+namespace Memory {
+	// One range of a ConsistentReader::readBatch.
+	struct ConsistentEntry {
+		uint32_t rmt_src;
+		size_t len;
+		void* local_dst;
+		bool versioned;          // Check a version field instead of reading twice.
+		int32_t version_offset;  // Of the (32 bit) version field from rmt_src, may be outside the range.
+		bool seqlock;            // An odd version means a write is in progress.
+		bool ok;                 // Set by readBatch.
+		uint32_t attempts;       // Set by readBatch, reads it took.
+	};
+
+	// Counters of a ConsistentReader.
+	struct ConsistentStats {
+		uint64_t reads;       // Ranges read.
+		uint64_t retries;     // Extra reads, over all ranges.
+		uint64_t torn;        // Ranges that changed while being read at least once.
+		uint64_t gave_up;     // Ranges that never read the same within the retry limit.
+		uint64_t failed;      // Ranges that couldn't be read at all.
+		uint32_t max_attempts;
+	};
+
+	// Reads (remote) structs the target may be changing at the same time without getting a mix of old and
+	// new fields, and without suspending the target.
+	// A plain read is repeated until two reads in a row are the same. A versioned read uses a version field
+	// the target bumps on every change: it reads the version, the struct, then the version again, and
+	// accepts the struct if both versions match (and are even, for seqlocks).
+	// Two plain reads agreeing only shows nothing changed between them, a writer thread that was preempted
+	// halfway through leaves a torn struct that reads the same every time. Prefer a version field when the
+	// target has one.
+	// readBatch does this for many ranges together, each round is one RemoteBackend::readBatch per step for
+	// every range still changing. Not thread safe.
+	class ConsistentReader {
+	public:
+		explicit ConsistentReader(RemoteBackend* backend, uint32_t max_retries = CONSISTENT_MAX_RETRIES);
+
+		// Read len bytes until two reads agree. Returns false if they never did or the range can't be read.
+		bool read(uint32_t rmt_src, void* local_dst, size_t len);
+
+		template <typename T>
+		bool read(uint32_t rmt_src, T& value) {
+			return read(rmt_src, &value, sizeof(T));
+		}
+
+		// Read len bytes bracketed by reads of the version field at version_offset.
+		bool readVersioned(uint32_t rmt_src, void* local_dst, size_t len, int32_t version_offset, bool seqlock = false);
+
+		template <typename T>
+		bool readVersioned(uint32_t rmt_src, T& value, int32_t version_offset, bool seqlock = false) {
+			return readVersioned(rmt_src, &value, sizeof(T), version_offset, seqlock);
+		}
+
+		// Read many ranges, setting ok and attempts on each entry. Returns the number read consistently.
+		size_t readBatch(ConsistentEntry* entries, size_t count);
+
+		size_t readBatch(std::vector<ConsistentEntry>& entries) {
+			return entries.empty() ? 0 : readBatch(&entries[0], entries.size());
+		}
+
+		void setMaxRetries(uint32_t retries) { max_retries = retries; }
+
+		const ConsistentStats& stats() const { return consistent_stats; }
+		void resetStats() { memset(&consistent_stats, 0, sizeof(consistent_stats)); }
+
+	private:
+		RemoteBackend* backend;
+		uint32_t max_retries;
+		ConsistentStats consistent_stats;
+
+		std::vector<size_t> pending;
+		std::vector<size_t> scratch_offsets;
+		std::vector<byte> scratch;
+		std::vector<uint32_t> versions;  // Before and after, per pending entry.
+		std::vector<Memory::Remote::ReadEntry> reads;
+		std::vector<Memory::Remote::ReadEntry> version_reads;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,225 @@
+#include "win32fleet.hpp"
+
+#include <atomic>
+#include <set>
+#include <stdio.h>
+#include <thread>
+
+// Key identifying a signature within one module build.
+static std::string signatureKey(const Memory::Remote::ModuleInfo& info, const char* data, const char* mask) {
+	char ident[64];
+	sprintf_s(ident, sizeof(ident), "|%08X|%08X|%08X|", info.size, info.timestamp, info.checksum);
+
+	std::string key(info.name);
+	key += ident;
+	key += mask;
+	key += '|';
+	key.append(data, strlen(mask));
+	return key;
+}
+
+// ------------------------
+// FLEET
+// ------------------------
+
+Memory::Fleet::Fleet(const char* exe_name, DWORD access) : concurrency(0) {
+	open(Memory::Remote::getPids(exe_name), access);
+}
+
+Memory::Fleet::Fleet(const std::vector<uint32_t>& pids, DWORD access) : concurrency(0) {
+	open(pids, access);
+}
+
+Memory::Fleet::~Fleet() {
+	for (size_t i = 0; i < procs.size(); i++)
+		if (procs[i].handle)
+			CloseHandle(procs[i].handle);
+}
+
+void Memory::Fleet::open(const std::vector<uint32_t>& pids, DWORD access) {
+	procs.resize(pids.size());
+	for (size_t i = 0; i < pids.size(); i++) {
+		procs[i].pid = pids[i];
+		procs[i].handle = OpenProcess(access, FALSE, pids[i]);
+		procs[i].error = procs[i].handle ? ERROR_SUCCESS : GetLastError();
+	}
+}
+
+// Run job(idx) for every process index on a pool of worker threads.
+// Workers pull the next index from a shared counter so a slow process doesn't hold up the others.
+void Memory::Fleet::forEach(const std::function<void(size_t idx)>& job) {
+	size_t threads = concurrency ? concurrency : std::thread::hardware_concurrency();
+	threads = min(max(threads, static_cast<size_t>(1)), procs.size());
+	if (threads <= 1) {
+		for (size_t i = 0; i < procs.size(); i++)
+			job(i);
+		return;
+	}
+
+	std::atomic<size_t> next(0);
+	auto worker = [&]() {
+		for (size_t idx = next++; idx < procs.size(); idx = next++)
+			job(idx);
+	};
+
+	std::vector<std::thread> pool;
+	for (size_t i = 1; i < threads; i++)
+		pool.emplace_back(worker);
+	worker();
+	for (size_t i = 0; i < pool.size(); i++)
+		pool[i].join();
+}
+
+std::vector<Memory::FleetResult<void*>> Memory::Fleet::scan(byte* start_addr, byte* end_addr, const char* data, const char* mask, uint32_t mem_type, uint32_t mem_prot) {
+	return run<void*>([&](const FleetMember& member, DWORD& error) -> void* {
+		void* addr = Memory::Remote::scan(member.handle, start_addr, end_addr, const_cast<char*>(data), const_cast<char*>(mask), mem_type, mem_prot);
+		if (!addr)
+			error = ERROR_NOT_FOUND;
+		return addr;
+	});
+}
+
+// The first process to need a signature for a given module build scans for it and publishes the
+// offset through a shared_future, any other process with the same build waits on that instead of scanning.
+// Offsets are stored relative to the module base since the base can differ between processes (ASLR).
+// Only found offsets stay cached: a scan can miss for reasons of its own process (access, a page that
+// couldn't be read), so on a miss the entry is dropped and every other process of this call scans its own
+// process, in parallel, without waiting on anyone. An offset one of them finds is cached for later calls.
+std::vector<Memory::FleetResult<void*>> Memory::Fleet::scanModule(const char* mod_name, const char* data, const char* mask, uint32_t mem_prot) {
+	std::set<std::string> missed;  // Keys whose shared scan missed during this call, under sig_lock.
+	return run<void*>([&](const FleetMember& member, DWORD& error) -> void* {
+		Memory::Remote::ModuleInfo info;
+		if (!Memory::Remote::getModInfo(member.handle, mod_name, &info)) {
+			error = ERROR_MOD_NOT_FOUND;
+			return 0;
+		}
+
+		std::string key = signatureKey(info, data, mask);
+		std::promise<uint32_t> promise;
+		std::shared_future<uint32_t> offset;
+		bool owner = false;
+		bool own_scan = false;
+		{
+			std::lock_guard<std::mutex> lock(sig_lock);
+			auto it = sig_cache.find(key);
+			if (it == sig_cache.end() && missed.count(key)) {
+				own_scan = true;
+			} else if (it == sig_cache.end()) {
+				offset = promise.get_future().share();
+				sig_cache[key] = offset;
+				owner = true;
+			} else {
+				offset = it->second;
+			}
+		}
+
+		byte* base = reinterpret_cast<byte*>(info.base);
+		if (owner) {
+			void* addr = Memory::Remote::scan(member.handle, base, base + info.size, const_cast<char*>(data), const_cast<char*>(mask), MEM_IMAGE, mem_prot);
+			promise.set_value(addr ? reinterpret_cast<uint32_t>(addr) - info.base : UINT32_MAX);
+			if (!addr) {
+				std::lock_guard<std::mutex> lock(sig_lock);
+				sig_cache.erase(key);
+				missed.insert(key);
+			}
+		}
+		if (!own_scan) {
+			if (offset.get() != UINT32_MAX)
+				return reinterpret_cast<void*>(info.base + offset.get());
+			if (owner) {
+				error = ERROR_NOT_FOUND;
+				return 0;
+			}
+		}
+
+		void* addr = Memory::Remote::scan(member.handle, base, base + info.size, const_cast<char*>(data), const_cast<char*>(mask), MEM_IMAGE, mem_prot);
+		if (!addr) {
+			error = ERROR_NOT_FOUND;
+			return 0;
+		}
+		std::promise<uint32_t> found;
+		found.set_value(reinterpret_cast<uint32_t>(addr) - info.base);
+		std::lock_guard<std::mutex> lock(sig_lock);
+		sig_cache.insert(std::make_pair(key, found.get_future().share()));
+		return addr;
+	});
+}
+
+// Writes are applied with one Memory::Remote::WriteBatch per process, in order where they overlap.
+// A process reports ERROR_PARTIAL_COPY if any of its writes failed.
+std::vector<Memory::FleetResult<bool>> Memory::Fleet::write(const std::vector<FleetWrite>& writes) {
+	return run<bool>([&](const FleetMember& member, DWORD& error) -> bool {
+		std::map<std::string, uint32_t> bases;
+		Memory::Remote::WriteBatch batch(member.handle);
+		for (size_t i = 0; i < writes.size(); i++) {
+			const FleetWrite& w = writes[i];
+			uint32_t addr = w.address;
+			if (w.mod_name) {
+				auto it = bases.find(w.mod_name);
+				if (it == bases.end())
+					it = bases.insert(std::make_pair(std::string(w.mod_name), Memory::Remote::getModBase(member.pid, w.mod_name))).first;
+				if (!it->second) {
+					error = ERROR_MOD_NOT_FOUND;
+					return false;
+				}
+				addr += it->second;
+			}
+
+			batch.add(reinterpret_cast<void*>(addr), w.data, w.len);
+		}
+
+		if (batch.commit() != writes.size()) {
+			error = ERROR_PARTIAL_COPY;
+			return false;
+		}
+		return true;
+	});
+}
+
+// Memory::Remote::placeHook doesn't report failure, so the jump is read back to check it actually got written.
+std::vector<Memory::FleetResult<void*>> Memory::Fleet::placeHook(const std::function<bool(const FleetMember& member, void*& rmt_target, void*& rmt_hook)>& resolve) {
+	return run<void*>([&](const FleetMember& member, DWORD& error) -> void* {
+		void* rmt_target = 0;
+		void* rmt_hook = 0;
+		if (!resolve(member, rmt_target, rmt_hook) || !rmt_target || !rmt_hook) {
+			error = ERROR_NOT_FOUND;
+			return 0;
+		}
+
+		void* oldmem = Memory::Remote::placeHook(member.handle, rmt_target, rmt_hook);
+		byte jmp[5];
+		if (!ReadProcessMemory(member.handle, rmt_target, jmp, 5, 0) || jmp[0] != 0xE9 ||
+			*reinterpret_cast<uint32_t*>(jmp + 1) != reinterpret_cast<uint32_t>(rmt_hook) - reinterpret_cast<uint32_t>(rmt_target) - 5) {
+			error = ERROR_PARTIAL_COPY;
+			free(oldmem);
+			return 0;
+		}
+
+		FlushInstructionCache(member.handle, rmt_target, 5);
+		return oldmem;
+	});
+}
+
+std::vector<Memory::FleetResult<bool>> Memory::Fleet::revertHook(const std::function<void*(const FleetMember& member)>& resolve_target, const std::vector<FleetResult<void*>>& oldmems) {
+	return run<bool>([&](const FleetMember& member, DWORD& error) -> bool {
+		void* oldmem = 0;
+		for (size_t i = 0; i < oldmems.size(); i++)
+			if (oldmems[i].pid == member.pid)
+				oldmem = oldmems[i].value;
+
+		void* rmt_target = oldmem ? resolve_target(member) : 0;
+		if (!rmt_target) {
+			error = ERROR_NOT_FOUND;
+			return false;
+		}
+
+		Memory::Remote::revertHook(member.handle, rmt_target, oldmem);
+		FlushInstructionCache(member.handle, rmt_target, 5);
+		return true;
+	});
+}
+
+void Memory::Fleet::clearSignatureCache() {
+	std::lock_guard<std::mutex> lock(sig_lock);
+	sig_cache.clear();
+}
\ No newline at end of file
@@ -0,0 +1,112 @@
+#pragma once
+#include <stdint.h>
+#include <Windows.h>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "win32memory.hpp"
+
+namespace Memory {
+	// Result of an operation on one process of a fleet.
+	template <typename T>
+	struct FleetResult {
+		uint32_t pid;
+		T value;
+		DWORD error;  // ERROR_SUCCESS if the operation worked, otherwise a GetLastError() style code.
+	};
+
+	// One process of a fleet.
+	struct FleetMember {
+		uint32_t pid;
+		HANDLE handle;  // 0 if the process couldn't be opened.
+		DWORD error;    // Why OpenProcess failed, if it did.
+	};
+
+	// A write to apply to every process of a fleet.
+	// If mod_name is set, address is an offset from that module's base in each process.
+	struct FleetWrite {
+		const char* mod_name;
+		uint32_t address;
+		const void* data;
+		size_t len;
+	};
+
+	// A set of processes (usually instances of the same program) that get scanned and patched together.
+	// Every operation runs on all processes in parallel and returns one result per process.
+	class Fleet {
+	public:
+		// Open every running process whose executable file has the given name.
+		explicit Fleet(const char* exe_name, DWORD access = PROCESS_ALL_ACCESS);
+
+		// Open the given processes.
+		explicit Fleet(const std::vector<uint32_t>& pids, DWORD access = PROCESS_ALL_ACCESS);
+
+		~Fleet();
+
+		Fleet(const Fleet&) = delete;
+		Fleet& operator=(const Fleet&) = delete;
+
+		// Processes in the fleet, including ones that failed to open.
+		const std::vector<FleetMember>& members() const { return procs; }
+
+		// Set how many processes get worked on at the same time. 0 means one per cpu.
+		void setConcurrency(size_t threads) { concurrency = threads; }
+
+		// Run a job on every process in parallel.
+		// The job returns its result and sets error to something other than ERROR_SUCCESS if it failed.
+		// Processes that failed to open are not passed to the job, they get their open error as result.
+		template <typename T>
+		std::vector<FleetResult<T>> run(const std::function<T(const FleetMember& member, DWORD& error)>& job) {
+			std::vector<FleetResult<T>> results(procs.size());
+			forEach([&](size_t idx) {
+				const FleetMember& member = procs[idx];
+				results[idx].pid = member.pid;
+				results[idx].value = T();
+				results[idx].error = member.error;
+				if (member.handle)
+					results[idx].value = job(member, results[idx].error);
+			});
+			return results;
+		}
+
+		// Scan every process (see Memory::Remote::scan).
+		std::vector<FleetResult<void*>> scan(byte* start_addr, byte* end_addr, const char* data, const char* mask, uint32_t mem_type, uint32_t mem_prot);
+
+		// Scan a module of every process for a signature.
+		// Each signature is only scanned for once per module build, processes whose module has the same
+		// identity (see Memory::Remote::ModuleInfo) reuse the offset found in the first one. A signature that
+		// wasn't found isn't cached, every process then scans for it itself.
+		std::vector<FleetResult<void*>> scanModule(const char* mod_name, const char* data, const char* mask, uint32_t mem_prot = PAGE_ANYREAD);
+
+		// Apply a list of writes to every process.
+		std::vector<FleetResult<bool>> write(const std::vector<FleetWrite>& writes);
+
+		// Hook a function in every process.
+		// resolve picks the (remote) target and hook for each process, since those usually differ per process.
+		// Results are the oldmem pointers to pass to revertHook.
+		std::vector<FleetResult<void*>> placeHook(const std::function<bool(const FleetMember& member, void*& rmt_target, void*& rmt_hook)>& resolve);
+
+		// Unhook a function in every process.
+		// oldmems are the results of the placeHook call that placed the hooks.
+		std::vector<FleetResult<bool>> revertHook(const std::function<void*(const FleetMember& member)>& resolve_target, const std::vector<FleetResult<void*>>& oldmems);
+
+		// Forget every cached signature offset.
+		void clearSignatureCache();
+
+	private:
+		std::vector<FleetMember> procs;
+		size_t concurrency;
+
+		// Signature offsets from module base, keyed by module identity + signature.
+		// UINT32_MAX if the signature isn't in that build.
+		std::mutex sig_lock;
+		std::map<std::string, std::shared_future<uint32_t>> sig_cache;
+
+		void open(const std::vector<uint32_t>& pids, DWORD access);
+		void forEach(const std::function<void(size_t idx)>& job);
+	};
+}
\ No newline at end of file
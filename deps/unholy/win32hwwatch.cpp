@@ -0,0 +1,305 @@
+#include "win32hwwatch.hpp"
+#include "win32autoio.hpp"
+
+// How long the debug thread waits for an event before it looks at the breakpoints again.
+#define HWWATCH_WAIT_MS 50
+
+// DR7 bits of a debug register: local enable, and the break condition / length field.
+#define DR7_ENABLE(slot)  (1u << ((slot) * 2))
+#define DR7_FIELD(slot)   (0xFu << (16 + (slot) * 4))
+
+// DR7 condition / length field for a write of len (1, 2 or 4) bytes.
+static DWORD dr7Field(size_t slot, uint32_t len) {
+	DWORD len_bits = len == 1 ? 0 : len == 2 ? 1 : 3;
+	return (1 | (len_bits << 2)) << (16 + slot * 4);
+}
+
+// ------------------------
+// HARDWARE WATCH
+// ------------------------
+
+Memory::HardwareWatch::HardwareWatch(uint32_t pid, double fallback_hz) : pid(pid), handle(Memory::Remote::cachedHandle(pid)), backend(handle),
+	fallback_hz(fallback_hz), attach_ok(false), next_id(0), queue(HWWATCH_QUEUE), queue_head(0), queue_count(0), stopping(false),
+	slots_dirty(false), poller(&backend) {
+	memset(&watch_stats, 0, sizeof(watch_stats));
+	for (size_t i = 0; i < HWWATCH_SLOTS; i++)
+		slot_owner[i] = HWWATCH_INVALID;
+
+	// DebugActiveProcess ties the debugger to the thread that calls it, so everything runs on debug_thread.
+	std::promise<bool> attached;
+	std::future<bool> result = attached.get_future();
+	debug_thread = std::thread(&HardwareWatch::debugLoop, this, &attached);
+	attach_ok = result.get();
+	if (!attach_ok)
+		debug_thread.join();
+}
+
+Memory::HardwareWatch::~HardwareWatch() {
+	stopping = true;
+	if (debug_thread.joinable())
+		debug_thread.join();
+	poller.stop();
+}
+
+// The initial value is read so changes can be told apart from writes of the same value.
+size_t Memory::HardwareWatch::add(uint32_t rmt_addr, size_t len, const WatchCallback& callback) {
+	byte value[HWWATCH_MAX_LEN];
+	if (!len || len > HWWATCH_MAX_LEN || !backend.read(rmt_addr, value, len))
+		return HWWATCH_INVALID;
+
+	std::lock_guard<std::mutex> guard(lock);
+	size_t id = next_id++;
+	Entry& entry = entries[id];
+	entry.addr = rmt_addr;
+	entry.len = static_cast<uint32_t>(len);
+	entry.slot = -1;
+	entry.poll_id = 0;
+	memcpy(entry.value, value, len);
+	entry.callback = callback;
+
+	// Debug registers only cover naturally aligned 1, 2 or 4 byte values on x86.
+	if (attach_ok && (len == 1 || len == 2 || len == 4) && rmt_addr % len == 0) {
+		for (int slot = 0; slot < HWWATCH_SLOTS; slot++) {
+			if (slot_owner[slot] == HWWATCH_INVALID) {
+				slot_owner[slot] = id;
+				entry.slot = slot;
+				slots_dirty = true;
+				break;
+			}
+		}
+	}
+
+	if (entry.slot < 0) {
+		uint32_t entry_len = entry.len;
+		entry.poll_id = poller.add(rmt_addr, len, [this, id, entry_len](const WatchEvent& event) {
+			Change change;
+			change.id = id;
+			change.addr = event.address;
+			change.len = entry_len;
+			memcpy(change.old_value, event.old_value, entry_len);
+			memcpy(change.new_value, event.new_value, entry_len);
+			std::lock_guard<std::mutex> guard(lock);
+			pushLocked(change);
+		});
+		if (!poller.running())
+			poller.start(fallback_hz);
+	}
+	return id;
+}
+
+void Memory::HardwareWatch::remove(size_t id) {
+	std::lock_guard<std::mutex> guard(lock);
+	auto it = entries.find(id);
+	if (it == entries.end())
+		return;
+
+	if (it->second.slot >= 0) {
+		slot_owner[it->second.slot] = HWWATCH_INVALID;
+		slots_dirty = true;
+	} else {
+		poller.remove(it->second.poll_id);
+	}
+	entries.erase(it);
+}
+
+bool Memory::HardwareWatch::hardware(size_t id) {
+	std::lock_guard<std::mutex> guard(lock);
+	auto it = entries.find(id);
+	return it != entries.end() && it->second.slot >= 0;
+}
+
+// Changes are taken off the queue under the lock, callbacks run without it so they can add and remove entries.
+size_t Memory::HardwareWatch::dispatch(DWORD timeout_ms) {
+	std::vector<Change> changes;
+	std::vector<WatchCallback> callbacks;
+	{
+		std::unique_lock<std::mutex> guard(lock);
+		if (!queue_count && timeout_ms)
+			queue_ready.wait_for(guard, std::chrono::milliseconds(timeout_ms), [this]() { return queue_count != 0; });
+
+		for (; queue_count; queue_count--, queue_head = (queue_head + 1) % HWWATCH_QUEUE) {
+			auto it = entries.find(queue[queue_head].id);
+			if (it == entries.end())
+				continue;
+			changes.push_back(queue[queue_head]);
+			callbacks.push_back(it->second.callback);
+		}
+	}
+
+	for (size_t i = 0; i < changes.size(); i++) {
+		WatchEvent event = { changes[i].id, changes[i].addr, changes[i].len, changes[i].old_value, changes[i].new_value };
+		callbacks[i](event);
+	}
+	return changes.size();
+}
+
+Memory::HardwareWatchStats Memory::HardwareWatch::stats() {
+	std::lock_guard<std::mutex> guard(lock);
+	HardwareWatchStats s = watch_stats;
+	s.hardware = 0;
+	s.polled = 0;
+	for (auto it = entries.begin(); it != entries.end(); ++it) {
+		if (it->second.slot >= 0)
+			s.hardware++;
+		else
+			s.polled++;
+	}
+	return s;
+}
+
+void Memory::HardwareWatch::pushLocked(const Change& change) {
+	if (queue_count == HWWATCH_QUEUE) {
+		queue_head = (queue_head + 1) % HWWATCH_QUEUE;
+		queue_count--;
+		watch_stats.dropped++;
+	}
+	queue[(queue_head + queue_count) % HWWATCH_QUEUE] = change;
+	queue_count++;
+	watch_stats.changes++;
+	queue_ready.notify_one();
+}
+
+// Set (or clear) our debug registers on a thread. Registers we don't own are left alone.
+void Memory::HardwareWatch::setThreadSlots(HANDLE thread, bool clear) {
+	CONTEXT ctx;
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.ContextFlags = CONTEXT_DEBUG_REGISTERS;
+	SuspendThread(thread);
+	if (GetThreadContext(thread, &ctx)) {
+		DWORD* drs[HWWATCH_SLOTS] = { &ctx.Dr0, &ctx.Dr1, &ctx.Dr2, &ctx.Dr3 };
+		std::lock_guard<std::mutex> guard(lock);
+		for (size_t slot = 0; slot < HWWATCH_SLOTS; slot++) {
+			ctx.Dr7 &= ~(DR7_ENABLE(slot) | DR7_FIELD(slot));
+			if (clear || slot_owner[slot] == HWWATCH_INVALID)
+				continue;
+
+			const Entry& entry = entries[slot_owner[slot]];
+			*drs[slot] = entry.addr;
+			ctx.Dr7 |= DR7_ENABLE(slot) | dr7Field(slot, entry.len);
+		}
+		SetThreadContext(thread, &ctx);
+	}
+	ResumeThread(thread);
+}
+
+void Memory::HardwareWatch::applySlots() {
+	for (auto it = threads.begin(); it != threads.end(); ++it)
+		setThreadSlots(it->second, false);
+}
+
+void Memory::HardwareWatch::clearSlots() {
+	for (auto it = threads.begin(); it != threads.end(); ++it)
+		setThreadSlots(it->second, true);
+}
+
+// Data breakpoints trap after the write, so the new value can be read right away while the thread is stopped.
+// Returns false if the trap wasn't from one of our registers (e.g. the target single stepping itself).
+bool Memory::HardwareWatch::onSingleStep(DWORD thread_id) {
+	auto thread = threads.find(thread_id);
+	if (thread == threads.end())
+		return false;
+
+	CONTEXT ctx;
+	memset(&ctx, 0, sizeof(ctx));
+	ctx.ContextFlags = CONTEXT_DEBUG_REGISTERS;
+	if (!GetThreadContext(thread->second, &ctx))
+		return false;
+	DWORD hit = ctx.Dr6 & 0xF;
+	if (!hit)
+		return false;
+
+	ctx.Dr6 = 0;
+	SetThreadContext(thread->second, &ctx);
+
+	std::lock_guard<std::mutex> guard(lock);
+	for (size_t slot = 0; slot < HWWATCH_SLOTS; slot++) {
+		if (!(hit & (1u << slot)) || slot_owner[slot] == HWWATCH_INVALID)
+			continue;
+
+		watch_stats.hits++;
+		Entry& entry = entries[slot_owner[slot]];
+		Change change;
+		if (!ReadProcessMemory(handle, reinterpret_cast<void*>(entry.addr), change.new_value, entry.len, 0) || !memcmp(change.new_value, entry.value, entry.len))
+			continue;
+
+		change.id = slot_owner[slot];
+		change.addr = entry.addr;
+		change.len = entry.len;
+		memcpy(change.old_value, entry.value, entry.len);
+		memcpy(entry.value, change.new_value, entry.len);
+		pushLocked(change);
+	}
+	return true;
+}
+
+// Exceptions other than our traps and the break-in breakpoint of the attach go back to the target unhandled.
+// Before detaching the registers are cleared and events still queued are let through, so no trap of ours
+// reaches the target after it stops being debugged.
+void Memory::HardwareWatch::debugLoop(std::promise<bool>* attached) {
+	if (!DebugActiveProcess(pid)) {
+		attached->set_value(false);
+		return;
+	}
+	DebugSetProcessKillOnExit(FALSE);
+	attached->set_value(true);
+
+	bool seen_break = false;
+	bool exited = false;
+	bool draining = false;
+	DEBUG_EVENT ev;
+	for (;;) {
+		if (stopping && !draining) {
+			clearSlots();
+			draining = true;
+		}
+		if (!draining && slots_dirty.exchange(false))
+			applySlots();
+
+		if (!WaitForDebugEvent(&ev, draining ? 0 : HWWATCH_WAIT_MS)) {
+			if (draining)
+				break;
+			continue;
+		}
+
+		DWORD status = DBG_CONTINUE;
+		switch (ev.dwDebugEventCode) {
+		case CREATE_PROCESS_DEBUG_EVENT:
+			if (ev.u.CreateProcessInfo.hFile)
+				CloseHandle(ev.u.CreateProcessInfo.hFile);
+			threads[ev.dwThreadId] = ev.u.CreateProcessInfo.hThread;
+			setThreadSlots(ev.u.CreateProcessInfo.hThread, draining);
+			break;
+		case CREATE_THREAD_DEBUG_EVENT:
+			threads[ev.dwThreadId] = ev.u.CreateThread.hThread;
+			setThreadSlots(ev.u.CreateThread.hThread, draining);
+			break;
+		case EXIT_THREAD_DEBUG_EVENT:
+			threads.erase(ev.dwThreadId);
+			break;
+		case LOAD_DLL_DEBUG_EVENT:
+			if (ev.u.LoadDll.hFile)
+				CloseHandle(ev.u.LoadDll.hFile);
+			break;
+		case EXIT_PROCESS_DEBUG_EVENT:
+			exited = true;
+			break;
+		case EXCEPTION_DEBUG_EVENT:
+			if (ev.u.Exception.ExceptionRecord.ExceptionCode == EXCEPTION_SINGLE_STEP && onSingleStep(ev.dwThreadId))
+				break;
+			if (ev.u.Exception.ExceptionRecord.ExceptionCode == EXCEPTION_BREAKPOINT && !seen_break) {
+				seen_break = true;
+				break;
+			}
+			status = DBG_EXCEPTION_NOT_HANDLED;
+			break;
+		}
+
+		ContinueDebugEvent(ev.dwProcessId, ev.dwThreadId, status);
+		if (exited)
+			break;
+	}
+
+	threads.clear();
+	if (!exited)
+		DebugActiveProcessStop(pid);
+}
\ No newline at end of file
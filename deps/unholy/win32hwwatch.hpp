@@ -0,0 +1,121 @@
+#pragma once
+#include <stdint.h>
+#include <Windows.h>
+#include <atomic>
+#include <condition_variable>
+#include <future>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "win32backend.hpp"
+#include "win32watch.hpp"
+
+// Number of debug registers (DR0 - DR3) available for watchpoints.
+#define HWWATCH_SLOTS     4
+
+// Largest value a HardwareWatch entry can have.
+#define HWWATCH_MAX_LEN   8
+
+// Hits the queue between the debug thread and dispatch() holds, older ones are dropped past that.
+#define HWWATCH_QUEUE     256
+
+// Returned by HardwareWatch::add when an entry can't be watched at all.
+#define HWWATCH_INVALID   static_cast<size_t>(-1)
+
+namespace Memory {
+	// Counters of a HardwareWatch.
+	struct HardwareWatchStats {
+		uint64_t hits;        // Writes trapped by a debug register.
+		uint64_t changes;     // Changes queued, from traps and from polling.
+		uint64_t dropped;     // Changes lost because the queue was full.
+		size_t hardware;      // Entries on a debug register.
+		size_t polled;        // Entries that fell back to polling.
+	};
+
+	// Notifies about writes to a few (remote) values using the debug registers of the target's threads.
+	// The tool attaches to the target as a debugger and sets a data breakpoint on every thread, so a write
+	// costs nothing until it happens. Entries that can't get a debug register (all four in use, not a
+	// 1, 2 or 4 byte aligned value, or the process can't be debugged) are polled with a WatchList instead.
+	// Changes are queued by the debug thread and handed to callbacks by dispatch(), so a slow callback
+	// never keeps the target stopped.
+	class HardwareWatch {
+	public:
+		// Attach to a process. fallback_hz is the polling rate of entries without a debug register.
+		explicit HardwareWatch(uint32_t pid, double fallback_hz = 100.0);
+
+		// Clears every breakpoint and detaches, the target keeps running.
+		~HardwareWatch();
+
+		HardwareWatch(const HardwareWatch&) = delete;
+		HardwareWatch& operator=(const HardwareWatch&) = delete;
+
+		// Whether the debugger could attach.
+		bool attached() const { return attach_ok; }
+
+		// Watch a value of up to HWWATCH_MAX_LEN bytes. Returns its id, or HWWATCH_INVALID.
+		size_t add(uint32_t rmt_addr, size_t len, const WatchCallback& callback);
+
+		// Stop watching an entry.
+		void remove(size_t id);
+
+		// Whether an entry is on a debug register (rather than polled).
+		bool hardware(size_t id);
+
+		// Wait up to timeout_ms for changes and call back for each of them on this thread.
+		// Returns the number of callbacks made.
+		size_t dispatch(DWORD timeout_ms = 0);
+
+		HardwareWatchStats stats();
+
+	private:
+		struct Entry {
+			uint32_t addr;
+			uint32_t len;
+			int slot;                // Debug register, or -1 if polled.
+			size_t poll_id;          // Id in the fallback WatchList.
+			byte value[HWWATCH_MAX_LEN];
+			WatchCallback callback;
+		};
+
+		struct Change {
+			size_t id;
+			uint32_t addr;
+			uint32_t len;
+			byte old_value[HWWATCH_MAX_LEN];
+			byte new_value[HWWATCH_MAX_LEN];
+		};
+
+		uint32_t pid;
+		HANDLE handle;
+		ProcessBackend backend;
+		double fallback_hz;
+		bool attach_ok;
+
+		std::mutex lock;
+		std::map<size_t, Entry> entries;
+		size_t slot_owner[HWWATCH_SLOTS];  // Entry id per debug register, HWWATCH_INVALID if free.
+		size_t next_id;
+		HardwareWatchStats watch_stats;
+
+		std::condition_variable queue_ready;
+		std::vector<Change> queue;         // Ring of HWWATCH_QUEUE changes.
+		size_t queue_head;
+		size_t queue_count;
+
+		std::thread debug_thread;
+		std::atomic<bool> stopping;
+		std::atomic<bool> slots_dirty;
+		std::map<DWORD, HANDLE> threads;   // Target threads, only touched by the debug thread.
+
+		WatchList poller;
+
+		void debugLoop(std::promise<bool>* attached);
+		void applySlots();
+		void clearSlots();
+		void setThreadSlots(HANDLE thread, bool clear);
+		bool onSingleStep(DWORD thread_id);
+		void pushLocked(const Change& change);
+	};
+}
\ No newline at end of file
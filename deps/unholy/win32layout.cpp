@@ -0,0 +1,226 @@
+#include "win32layout.hpp"
+
+#include <algorithm>
+
+// Mirrors are carved out of blocks of this size, bigger ones get a block of their own.
+#define LAYOUT_BLOCK_SIZE 0x10000
+
+// ------------------------
+// STRUCT LAYOUT
+// ------------------------
+
+// A field that doesn't fit either struct, or a pointer whose target mirror has a different size than the
+// member points to, makes the layout invalid, and a GraphReader won't read it.
+Memory::StructLayout& Memory::StructLayout::add(const LayoutField& f, size_t target_local_size) {
+	uint32_t local_size_needed = f.kind == LAYOUT_VALUE ? f.size : sizeof(void*);
+	if (f.rmt_offset + f.size > rmt_size || f.local_offset + local_size_needed > local_size)
+		layout_ok = false;
+	if (f.kind == LAYOUT_ARRAY && !f.count && (f.rmt_count_offset + sizeof(uint32_t) > rmt_size || f.local_count_offset + sizeof(uint32_t) > local_size))
+		layout_ok = false;
+	if (target_local_size && f.target->localSize() != target_local_size)
+		layout_ok = false;
+
+	layout_fields.push_back(f);
+	return *this;
+}
+
+// ------------------------
+// GRAPH READER
+// ------------------------
+
+Memory::GraphReader::GraphReader(RemoteBackend* backend, size_t max_depth) : backend(backend), max_depth(max_depth), block_pos(0), block_left(0),
+	batch_count(0), object_count(0), byte_count(0) {}
+
+void Memory::GraphReader::clear() {
+	blocks.clear();
+	block_pos = 0;
+	block_left = 0;
+	column_sets.clear();
+	seen.clear();
+	origins.clear();
+	batch_count = 0;
+	object_count = 0;
+	byte_count = 0;
+}
+
+// Zeroed, 8 byte aligned memory that lives until clear().
+byte* Memory::GraphReader::allocate(size_t len) {
+	len = (max(len, static_cast<size_t>(1)) + 7) & ~static_cast<size_t>(7);
+	if (len > LAYOUT_BLOCK_SIZE / 4) {
+		blocks.push_back(std::unique_ptr<byte[]>(new byte[len]()));
+		return blocks.back().get();
+	}
+
+	if (len > block_left) {
+		blocks.push_back(std::unique_ptr<byte[]>(new byte[LAYOUT_BLOCK_SIZE]()));
+		block_pos = blocks.back().get();
+		block_left = LAYOUT_BLOCK_SIZE;
+	}
+	byte* local = block_pos;
+	block_pos += len;
+	block_left -= len;
+	return local;
+}
+
+// Queue a read for the next level and return where its mirror (or columns) will be.
+// Single structs are only read once per graph, asking again returns the same mirror, or 0 if it failed.
+void* Memory::GraphReader::schedule(std::vector<Pending>& level, uint32_t rmt_addr, const StructLayout* layout, uint32_t count, bool as_columns) {
+	std::pair<uint32_t, const StructLayout*> key(rmt_addr, layout);
+	bool single = count == 1 && !as_columns;
+	if (single) {
+		auto it = seen.find(key);
+		if (it != seen.end())
+			return it->second;
+	}
+
+	Pending pending = { rmt_addr, layout, count, 0, 0, 0 };
+	if (as_columns) {
+		column_sets.push_back(std::unique_ptr<RecordColumns>(new RecordColumns()));
+		pending.columns = column_sets.back().get();
+		pending.columns->layout = layout;
+		pending.columns->count = count;
+	} else {
+		pending.local = allocate(layout->localSize() * count);
+	}
+	level.push_back(pending);
+
+	if (single)
+		seen[key] = pending.local;
+	return as_columns ? static_cast<void*>(pending.columns) : static_cast<void*>(pending.local);
+}
+
+// Copy the fields of one struct from its remote bytes to its mirror, queueing what it points to.
+void Memory::GraphReader::decode(const byte* raw, const StructLayout& layout, byte* local, size_t depth, std::vector<Pending>& next, std::vector<Fixup>& fixups) {
+	const std::vector<LayoutField>& fields = layout.fields();
+	for (size_t i = 0; i < fields.size(); i++) {
+		const LayoutField& f = fields[i];
+		if (f.kind == LAYOUT_VALUE) {
+			memcpy(local + f.local_offset, raw + f.rmt_offset, f.size);
+			continue;
+		}
+
+		uint32_t rmt_ptr;
+		memcpy(&rmt_ptr, raw + f.rmt_offset, sizeof(rmt_ptr));
+		uint32_t count = f.count;
+		if (f.kind == LAYOUT_POINTER) {
+			count = 1;
+		} else if (!count) {
+			memcpy(&count, raw + f.rmt_count_offset, sizeof(count));
+			if (count > LAYOUT_MAX_COUNT)
+				count = 0;
+			memcpy(local + f.local_count_offset, &count, sizeof(count));
+		}
+
+		void** slot = reinterpret_cast<void**>(local + f.local_offset);
+		*slot = 0;
+		if (!rmt_ptr || !count || depth + 1 >= max_depth)
+			continue;
+
+		*slot = schedule(next, rmt_ptr, f.target, count, f.columns);
+		if (*slot) {
+			Fixup fixup = { slot, static_cast<byte*>(*slot) };
+			fixups.push_back(fixup);
+		}
+	}
+}
+
+// Failed reads are handled before anything of the level gets decoded, so a mirror that points to a failed
+// struct never sees it: its fixup nulls the pointer, and later lookups of the struct get 0 from seen.
+size_t Memory::GraphReader::readGraph(const uint32_t* rmt_addrs, size_t count, const StructLayout& layout, void** roots) {
+	clear();
+	for (size_t i = 0; i < count; i++)
+		roots[i] = 0;
+	if (!layout.valid())
+		return 0;
+
+	std::vector<Pending> level, next;
+	std::vector<Fixup> fixups, next_fixups;
+	for (size_t i = 0; i < count; i++) {
+		if (!rmt_addrs[i] || max_depth == 0)
+			continue;
+		roots[i] = schedule(level, rmt_addrs[i], &layout, 1, false);
+		Fixup fixup = { &roots[i], static_cast<byte*>(roots[i]) };
+		fixups.push_back(fixup);
+	}
+
+	std::vector<byte> raw;
+	std::vector<Memory::Remote::ReadEntry> reads;
+	std::vector<byte*> failed;
+	for (size_t depth = 0; !level.empty(); depth++) {
+		size_t total = 0;
+		for (size_t i = 0; i < level.size(); i++) {
+			level[i].raw_offset = total;
+			total += static_cast<size_t>(level[i].layout->remoteSize()) * level[i].count;
+		}
+		raw.resize(max(total, static_cast<size_t>(1)));
+
+		reads.clear();
+		for (size_t i = 0; i < level.size(); i++) {
+			Memory::Remote::ReadEntry read = { reinterpret_cast<void*>(level[i].rmt_addr), static_cast<size_t>(level[i].layout->remoteSize()) * level[i].count, &raw[level[i].raw_offset], false };
+			reads.push_back(read);
+		}
+		backend->readBatch(&reads[0], reads.size());
+		batch_count++;
+		byte_count += total;
+
+		failed.clear();
+		for (size_t i = 0; i < level.size(); i++) {
+			if (reads[i].ok)
+				continue;
+			failed.push_back(level[i].local ? level[i].local : reinterpret_cast<byte*>(level[i].columns));
+			if (level[i].local && level[i].count == 1)
+				seen[std::make_pair(level[i].rmt_addr, level[i].layout)] = 0;
+		}
+		std::sort(failed.begin(), failed.end());
+		for (size_t i = 0; i < fixups.size() && !failed.empty(); i++)
+			if (std::binary_search(failed.begin(), failed.end(), fixups[i].target))
+				*fixups[i].slot = 0;
+
+		next.clear();
+		next_fixups.clear();
+		for (size_t i = 0; i < level.size(); i++) {
+			if (!reads[i].ok)
+				continue;
+
+			const Pending& p = level[i];
+			const StructLayout& el = *p.layout;
+			const byte* src = &raw[p.raw_offset];
+			object_count += p.count;
+			if (p.columns) {
+				// Only value fields get a column, pointers inside column arrays aren't followed.
+				const std::vector<LayoutField>& fields = el.fields();
+				p.columns->data.resize(fields.size());
+				for (size_t f = 0; f < fields.size(); f++) {
+					if (fields[f].kind != LAYOUT_VALUE)
+						continue;
+					byte* column = new byte[static_cast<size_t>(fields[f].size) * p.count];
+					p.columns->data[f].reset(column);
+					for (uint32_t e = 0; e < p.count; e++)
+						memcpy(column + static_cast<size_t>(e) * fields[f].size, src + static_cast<size_t>(e) * el.remoteSize() + fields[f].rmt_offset, fields[f].size);
+				}
+				origins[p.columns] = p.rmt_addr;
+				continue;
+			}
+
+			for (uint32_t e = 0; e < p.count; e++) {
+				byte* local = p.local + e * el.localSize();
+				decode(src + static_cast<size_t>(e) * el.remoteSize(), el, local, depth, next, next_fixups);
+				origins[local] = p.rmt_addr + e * el.remoteSize();
+			}
+		}
+
+		level.swap(next);
+		fixups.swap(next_fixups);
+	}
+
+	size_t read_count = 0;
+	for (size_t i = 0; i < count; i++)
+		if (roots[i])
+			read_count++;
+	return read_count;
+}
+
+uint32_t Memory::GraphReader::remoteAddress(const void* local) const {
+	auto it = origins.find(local);
+	return it == origins.end() ? 0 : it->second;
+}
\ No newline at end of file
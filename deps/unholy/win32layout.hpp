@@ -0,0 +1,222 @@
+#pragma once
+#include <stdint.h>
+#include <Windows.h>
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "win32backend.hpp"
+#include "win32remoteptr.hpp"
+
+// Levels of an object graph a GraphReader reads unless told otherwise.
+#define LAYOUT_DEFAULT_DEPTH  4
+
+// Counted arrays with a bigger count than this are treated as garbage and not read.
+#define LAYOUT_MAX_COUNT      0x10000
+
+namespace Memory {
+	class StructLayout;
+	class RecordColumns;
+
+	// How a field of a StructLayout is read.
+	enum LayoutKind {
+		LAYOUT_VALUE,    // Bytes copied as they are (scalars, fixed arrays of scalars, plain nested structs).
+		LAYOUT_POINTER,  // Pointer to one described struct.
+		LAYOUT_ARRAY     // Pointer to a fixed or counted array of described structs.
+	};
+
+	struct LayoutField {
+		LayoutKind kind;
+		uint32_t rmt_offset;
+		uint32_t local_offset;
+		uint32_t size;                // Bytes, for values.
+		const StructLayout* target;   // Layout pointed to, for pointers and arrays.
+		uint32_t count;               // Element count of fixed arrays, 0 for counted ones.
+		uint32_t rmt_count_offset;    // Where counted arrays keep their (32 bit) count remotely and locally.
+		uint32_t local_count_offset;
+		bool columns;                 // Arrays read as RecordColumns instead of an array of structs.
+	};
+
+	// Describes how a remote struct maps onto a local mirror struct T.
+	// Remote offsets are given per field, so the mirror only has the fields that are needed, in any order.
+	// Pointers in the mirror point to local mirrors of what they point to remotely.
+	//   StructLayout player = StructLayout::of<Player>(0x180);
+	//   player.field(&Player::health, 0xF8).pointer(&Player::weapon, 0x104, weapon);
+	class StructLayout {
+	public:
+		// Layout of a mirror struct T for a remote struct of rmt_size bytes.
+		template <typename T>
+		static StructLayout of(uint32_t rmt_size) {
+			static_assert(std::is_trivially_copyable<T>::value, "mirror structs must be trivially copyable");
+			return StructLayout(rmt_size, sizeof(T));
+		}
+
+		// Copy a member from a remote offset.
+		template <typename T, typename M>
+		StructLayout& field(M T::* member, uint32_t rmt_offset) {
+			LayoutField f = { LAYOUT_VALUE, rmt_offset, memberOffset(member), sizeof(M), 0, 0, 0, 0, false };
+			return add(f);
+		}
+
+		// Follow a pointer at a remote offset to a struct described by target.
+		template <typename T, typename U>
+		StructLayout& pointer(U* T::* member, uint32_t rmt_offset, const StructLayout& target) {
+			LayoutField f = { LAYOUT_POINTER, rmt_offset, memberOffset(member), sizeof(uint32_t), &target, 0, 0, 0, false };
+			return add(f, sizeof(U));
+		}
+
+		// Follow a pointer at a remote offset to an array of count structs described by element.
+		template <typename T, typename U>
+		StructLayout& array(U* T::* member, uint32_t rmt_offset, uint32_t count, const StructLayout& element) {
+			LayoutField f = { LAYOUT_ARRAY, rmt_offset, memberOffset(member), sizeof(uint32_t), &element, count, 0, 0, false };
+			return add(f, sizeof(U));
+		}
+
+		// Follow a pointer at a remote offset to an array of structs whose (32 bit) count is at another
+		// remote offset. The count is stored in count_member.
+		template <typename T, typename U>
+		StructLayout& array(U* T::* member, uint32_t rmt_offset, uint32_t T::* count_member, uint32_t rmt_count_offset, const StructLayout& element) {
+			LayoutField f = { LAYOUT_ARRAY, rmt_offset, memberOffset(member), sizeof(uint32_t), &element, 0, rmt_count_offset, memberOffset(count_member), false };
+			return add(f, sizeof(U));
+		}
+
+		// Same as array, but the elements are read into one column per value field (structure of arrays).
+		// The member receives a RecordColumns*, see there.
+		template <typename T>
+		StructLayout& columns(RecordColumns* T::* member, uint32_t rmt_offset, uint32_t count, const StructLayout& element);
+
+		// Same as columns, with a counted array.
+		template <typename T>
+		StructLayout& columns(RecordColumns* T::* member, uint32_t rmt_offset, uint32_t T::* count_member, uint32_t rmt_count_offset, const StructLayout& element);
+
+		uint32_t remoteSize() const { return rmt_size; }
+		size_t localSize() const { return local_size; }
+		const std::vector<LayoutField>& fields() const { return layout_fields; }
+
+		// Whether every field fits the remote struct and every pointer matches its target's mirror size.
+		bool valid() const { return layout_ok; }
+
+	private:
+		uint32_t rmt_size;
+		size_t local_size;
+		std::vector<LayoutField> layout_fields;
+		bool layout_ok;
+
+		StructLayout(uint32_t rmt_size, size_t local_size) : rmt_size(rmt_size), local_size(local_size), layout_ok(true) {}
+		StructLayout& add(const LayoutField& f, size_t target_local_size = 0);
+	};
+
+	// Array of records read as one column per value field.
+	class RecordColumns {
+	public:
+		size_t size() const { return count; }
+
+		// Column of a member of the element's mirror struct, or 0 if the layout doesn't read that member.
+		template <typename T, typename M>
+		const M* column(M T::* member) const {
+			uint32_t offset = memberOffset(member);
+			for (size_t i = 0; i < layout->fields().size(); i++)
+				if (layout->fields()[i].kind == LAYOUT_VALUE && layout->fields()[i].local_offset == offset)
+					return reinterpret_cast<const M*>(data[i].get());
+			return 0;
+		}
+
+	private:
+		friend class GraphReader;
+		const StructLayout* layout;
+		size_t count;
+		std::vector<std::unique_ptr<byte[]>> data;  // Per field, empty for fields that aren't values.
+	};
+
+	template <typename T>
+	StructLayout& StructLayout::columns(RecordColumns* T::* member, uint32_t rmt_offset, uint32_t count, const StructLayout& element) {
+		LayoutField f = { LAYOUT_ARRAY, rmt_offset, memberOffset(member), sizeof(uint32_t), &element, count, 0, 0, true };
+		return add(f);
+	}
+
+	template <typename T>
+	StructLayout& StructLayout::columns(RecordColumns* T::* member, uint32_t rmt_offset, uint32_t T::* count_member, uint32_t rmt_count_offset, const StructLayout& element) {
+		LayoutField f = { LAYOUT_ARRAY, rmt_offset, memberOffset(member), sizeof(uint32_t), &element, 0, rmt_count_offset, memberOffset(count_member), true };
+		return add(f);
+	}
+
+	// Reads graphs of remote structs described by StructLayouts into local mirrors.
+	// Objects are read level by level, everything one level deep in the graph with a single
+	// RemoteBackend::readBatch, so a graph of depth N costs N batches however wide it is.
+	// Objects reached more than once (shared or cyclic pointers) are read once. Pointers that couldn't be
+	// read, or lead deeper than the depth limit, are null in the mirrors.
+	// The mirrors belong to the reader and stay valid until the next read or clear().
+	class GraphReader {
+	public:
+		explicit GraphReader(RemoteBackend* backend, size_t max_depth = LAYOUT_DEFAULT_DEPTH);
+
+		// Read the graph under a (remote) struct. Returns its mirror, or 0 if it couldn't be read.
+		template <typename T>
+		T* read(uint32_t rmt_addr, const StructLayout& layout) {
+			if (layout.localSize() != sizeof(T))
+				return 0;
+			void* root = 0;
+			readGraph(&rmt_addr, 1, layout, &root);
+			return static_cast<T*>(root);
+		}
+
+		// Read the graphs under many (remote) structs of the same layout together.
+		template <typename T>
+		std::vector<T*> readAll(const std::vector<uint32_t>& rmt_addrs, const StructLayout& layout) {
+			std::vector<T*> roots(rmt_addrs.size());
+			if (layout.localSize() == sizeof(T) && !rmt_addrs.empty())
+				readGraph(&rmt_addrs[0], rmt_addrs.size(), layout, reinterpret_cast<void**>(&roots[0]));
+			return roots;
+		}
+
+		// Read graphs, root mirrors go to roots (0 for those that couldn't be read).
+		// Returns the number of roots read.
+		size_t readGraph(const uint32_t* rmt_addrs, size_t count, const StructLayout& layout, void** roots);
+
+		// Remote address a mirror object was read from, or 0.
+		uint32_t remoteAddress(const void* local) const;
+
+		// Free every mirror.
+		void clear();
+
+		void setMaxDepth(size_t depth) { max_depth = depth; }
+
+		// Batches, objects and remote bytes of the last read.
+		size_t batches() const { return batch_count; }
+		size_t objects() const { return object_count; }
+		size_t bytes() const { return byte_count; }
+
+	private:
+		// A struct, or an array of them, to read.
+		struct Pending {
+			uint32_t rmt_addr;
+			const StructLayout* layout;
+			uint32_t count;
+			byte* local;              // Mirrors, 0 for column arrays.
+			RecordColumns* columns;
+			size_t raw_offset;        // Of the remote bytes in the staging buffer.
+		};
+
+		// A mirror pointer to null if its target can't be read.
+		struct Fixup {
+			void** slot;
+			byte* target;             // Mirror (or RecordColumns) the slot points to.
+		};
+
+		RemoteBackend* backend;
+		size_t max_depth;
+		std::vector<std::unique_ptr<byte[]>> blocks;
+		byte* block_pos;
+		size_t block_left;
+		std::vector<std::unique_ptr<RecordColumns>> column_sets;
+		std::map<std::pair<uint32_t, const StructLayout*>, byte*> seen;
+		std::map<const void*, uint32_t> origins;
+		size_t batch_count;
+		size_t object_count;
+		size_t byte_count;
+
+		byte* allocate(size_t len);
+		void* schedule(std::vector<Pending>& level, uint32_t rmt_addr, const StructLayout* layout, uint32_t count, bool as_columns);
+		void decode(const byte* raw, const StructLayout& layout, byte* local, size_t depth, std::vector<Pending>& next, std::vector<Fixup>& fixups);
+	};
+}
\ No newline at end of file
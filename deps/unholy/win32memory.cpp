@@ -1,5 +1,7 @@
 #include "win32memory.hpp"
+#include "win32buffer.hpp"
 
+#include <algorithm>
 #include <stdio.h>
 #include <psapi.h>
 #include <TlHelp32.h>
@@ -154,6 +156,68 @@ uint32_t Memory::Remote::getModBase(uint32_t pid, const char* mod_name) {
 	return base;
 }
 
+// Retrieve the PIDs of every process whose executable file has the given name.
+// Same name matching as getPid, but keeps all of them instead of only the last one.
+std::vector<uint32_t> Memory::Remote::getPids(const char* exe_name) {
+	std::vector<uint32_t> pids;
+	HANDLE snap_handle = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+	if (snap_handle == INVALID_HANDLE_VALUE)
+		return pids;
+
+	PROCESSENTRY32 pe32;
+	memset(&pe32, 0, sizeof(PROCESSENTRY32));
+	pe32.dwSize = sizeof(PROCESSENTRY32);
+	if (Process32First(snap_handle, &pe32)) {
+		do {
+			if (!strncmp(pe32.szExeFile, exe_name, strlen(exe_name)))
+				pids.push_back(pe32.th32ProcessID);
+		} while (Process32Next(snap_handle, &pe32));
+	}
+
+	CloseHandle(snap_handle);
+
+	return pids;
+}
+
+// Retrieve the base address and build identity of a module in a remote process.
+// The module is looked up the same way as getModBase, then its PE headers are read to get
+// SizeOfImage, the link timestamp and the checksum.
+// Returns false if the module isn't loaded or its headers can't be read.
+bool Memory::Remote::getModInfo(HANDLE rmt_handle, const char* mod_name, ModuleInfo* info) {
+	HANDLE snap_handle = CreateToolhelp32Snapshot(TH32CS_SNAPMODULE | TH32CS_SNAPMODULE32, GetProcessId(rmt_handle));
+	if (snap_handle == INVALID_HANDLE_VALUE)
+		return false;
+
+	MODULEENTRY32 me32;
+	memset(&me32, 0, sizeof(MODULEENTRY32));
+	me32.dwSize = sizeof(MODULEENTRY32);
+	memset(info, 0, sizeof(ModuleInfo));
+	if (Module32First(snap_handle, &me32)) {
+		do {
+			if (!strncmp(me32.szModule, mod_name, strlen(mod_name))) {
+				info->base = reinterpret_cast<uint32_t>(me32.modBaseAddr);
+				strncpy(info->name, me32.szModule, sizeof(info->name) - 1);
+			}
+		} while (Module32Next(snap_handle, &me32));
+	}
+
+	CloseHandle(snap_handle);
+	if (!info->base)
+		return false;
+
+	IMAGE_DOS_HEADER dos_header;
+	IMAGE_NT_HEADERS32 nt_headers;
+	if (!ReadProcessMemory(rmt_handle, reinterpret_cast<void*>(info->base), &dos_header, sizeof(dos_header), 0) || dos_header.e_magic != IMAGE_DOS_SIGNATURE)
+		return false;
+	if (!ReadProcessMemory(rmt_handle, reinterpret_cast<void*>(info->base + dos_header.e_lfanew), &nt_headers, sizeof(nt_headers), 0) || nt_headers.Signature != IMAGE_NT_SIGNATURE)
+		return false;
+
+	info->size = nt_headers.OptionalHeader.SizeOfImage;
+	info->timestamp = nt_headers.FileHeader.TimeDateStamp;
+	info->checksum = nt_headers.OptionalHeader.CheckSum;
+	return true;
+}
+
 // Hook function in a remote process.
 // Takes handle to the remote process, the (remote) target function to be hooked, and the (remote) function that should be called in its place.
 // Returns pointer to "oldmem" data necessary to unhook function.
@@ -223,32 +287,515 @@ char* Memory::Remote::allocReadString(HANDLE rmt_handle, void* rmt_src) {
 	return reinterpret_cast<char*>(allocRead(rmt_handle, rmt_src, str_size, PAGE_READWRITE));
 }
 
+// Size of a page of memory.
+static DWORD pageSize() {
+	static DWORD page_size = 0;
+	if (!page_size) {
+		SYSTEM_INFO si;
+		GetSystemInfo(&si);
+		page_size = si.dwPageSize;
+	}
+	return page_size;
+}
+
+// Read a group of batch entries that lie within [rmt_start, rmt_end) with one ReadProcessMemory call.
+// If the group can't be read whole, entries inside the part that was read are still copied from it and
+// the rest get read one by one, so one bad pointer doesn't fail its neighbours.
+static void readBatchGroup(HANDLE rmt_handle, Memory::Remote::ReadEntry* entries, const uint32_t* group, size_t group_len, byte* rmt_start, byte* rmt_end, std::vector<byte>& staging) {
+	Memory::Remote::ReadEntry& first = entries[group[0]];
+	if (group_len == 1) {
+		first.ok = ReadProcessMemory(rmt_handle, first.rmt_src, first.local_dst, first.len, 0) != 0;
+		return;
+	}
+
+	size_t span = rmt_end - rmt_start;
+	if (staging.size() < span)
+		staging.resize(span);
+
+	SIZE_T bytes_read = 0;
+	if (!ReadProcessMemory(rmt_handle, rmt_start, &staging[0], span, &bytes_read))
+		bytes_read = min(static_cast<size_t>(bytes_read), span);
+
+	for (size_t i = 0; i < group_len; i++) {
+		Memory::Remote::ReadEntry& entry = entries[group[i]];
+		size_t offset = static_cast<byte*>(entry.rmt_src) - rmt_start;
+		if (offset + entry.len <= bytes_read) {
+			memcpy(entry.local_dst, &staging[offset], entry.len);
+			entry.ok = true;
+		} else {
+			entry.ok = ReadProcessMemory(rmt_handle, entry.rmt_src, entry.local_dst, entry.len, 0) != 0;
+		}
+	}
+}
+
+// Read many (remote) ranges into local buffers.
+// Entries are sorted by address, and entries that overlap or lie within max_gap bytes of each other
+// (up to a span of READ_BATCH_MAX) are read with one ReadProcessMemory call into a staging buffer and
+// copied out from there. Every entry gets its own ok flag, a failed read only fails the entries it covers.
+// Returns the number of entries that were read successfully.
+size_t Memory::Remote::readBatch(HANDLE rmt_handle, ReadEntry* entries, size_t count, size_t max_gap) {
+	std::vector<uint32_t> order;
+	order.reserve(count);
+	for (size_t i = 0; i < count; i++) {
+		entries[i].ok = entries[i].len == 0;
+		if (entries[i].len)
+			order.push_back(static_cast<uint32_t>(i));
+	}
+
+	std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+		return entries[a].rmt_src < entries[b].rmt_src;
+	});
+
+	static thread_local std::vector<byte> staging;
+	size_t group_first = 0;
+	byte* group_start = 0;
+	byte* group_end = 0;
+	for (size_t i = 0; i < order.size(); i++) {
+		byte* entry_start = static_cast<byte*>(entries[order[i]].rmt_src);
+		byte* entry_end = entry_start + entries[order[i]].len;
+		if (i > group_first) {
+			// Keep growing the group while the entry is close enough and the span stays small enough.
+			if (entry_start <= group_end + max_gap && static_cast<size_t>(max(group_end, entry_end) - group_start) <= READ_BATCH_MAX) {
+				group_end = max(group_end, entry_end);
+				continue;
+			}
+
+			readBatchGroup(rmt_handle, entries, &order[group_first], i - group_first, group_start, group_end, staging);
+		}
+
+		group_first = i;
+		group_start = entry_start;
+		group_end = entry_end;
+	}
+
+	if (group_first < order.size())
+		readBatchGroup(rmt_handle, entries, &order[group_first], order.size() - group_first, group_start, group_end, staging);
+
+	size_t ok_count = 0;
+	for (size_t i = 0; i < count; i++)
+		ok_count += entries[i].ok;
+	return ok_count;
+}
+
+// Protection that adds write access to a page protection, or 0 if it is already writable.
+static DWORD writableProtection(DWORD protect) {
+	switch (protect & 0xFF) {
+	case PAGE_NOACCESS:
+	case PAGE_READONLY:
+		return (protect & ~0xFF) | PAGE_READWRITE;
+	case PAGE_EXECUTE:
+	case PAGE_EXECUTE_READ:
+		return (protect & ~0xFF) | PAGE_EXECUTE_READWRITE;
+	default:
+		return 0;
+	}
+}
+
+Memory::Remote::WriteBatch::WriteBatch(HANDLE rmt_handle, size_t max_gap) : handle(rmt_handle), max_gap(max_gap), syscall_count(0) {}
+
+Memory::Remote::WriteBatch::~WriteBatch() {
+	releaseResults();
+	for (size_t i = 0; i < writes.size(); i++)
+		if (writes[i].oldmem)
+			free(writes[i].oldmem);
+}
+
+// Free the oldmem of hooks from the last commit that never got claimed.
+void Memory::Remote::WriteBatch::releaseResults() {
+	for (size_t i = 0; i < results.size(); i++)
+		if (results[i].oldmem)
+			free(results[i].oldmem);
+	results.clear();
+}
+
+size_t Memory::Remote::WriteBatch::add(void* rmt_dst, const void* local_src, size_t len) {
+	if (writes.empty())
+		releaseResults();
+
+	PendingWrite write = { static_cast<byte*>(rmt_dst), len, data.size(), 0, 0 };
+	data.insert(data.end(), static_cast<const byte*>(local_src), static_cast<const byte*>(local_src) + len);
+	writes.push_back(write);
+	return writes.size() - 1;
+}
+
+size_t Memory::Remote::WriteBatch::addHook(void* rmt_target, void* rmt_hook) {
+	byte buffer[5];
+	buffer[0] = 0xE9;
+	*(reinterpret_cast<uint32_t*>(buffer + 1)) = reinterpret_cast<uint32_t>(rmt_hook) - reinterpret_cast<uint32_t>(rmt_target) - 5;
+
+	size_t index = add(rmt_target, buffer, 5);
+	writes[index].oldmem = malloc(5);
+	return index;
+}
+
+size_t Memory::Remote::WriteBatch::addRevertHook(void* rmt_target, void* oldmem) {
+	size_t index = add(rmt_target, oldmem, 5);
+	writes[index].free_after = oldmem;
+	return index;
+}
+
+void* Memory::Remote::WriteBatch::oldmem(size_t index) {
+	if (index >= results.size() || !results[index].ok)
+		return 0;
+
+	void* mem = results[index].oldmem;
+	results[index].oldmem = 0;
+	return mem;
+}
+
+// Commit happens in four steps:
+//   1. writes are sorted and merged into spans of touching (or max_gap close) writes, later writes win where they overlap
+//   2. the pages under the spans are split into runs with the same protection, each read-only run gets made writable once
+//   3. the original bytes under every hook are read with one readBatch, now that their pages can be read
+//   4. each span is written with one WriteProcessMemory call, then protections are restored and code runs flushed
+// A span whose gap bytes can't be read falls back to writing its writes one by one. Hooks whose bytes
+// couldn't be saved aren't written. Empty writes always succeed.
+size_t Memory::Remote::WriteBatch::commit() {
+	releaseResults();
+	results.resize(writes.size());
+	syscall_count = 0;
+	for (size_t i = 0; i < writes.size(); i++) {
+		results[i].ok = !writes[i].len;
+		results[i].oldmem = writes[i].oldmem;
+	}
+
+	// 1. Merge writes into spans.
+	std::vector<uint32_t> order;
+	for (size_t i = 0; i < writes.size(); i++)
+		if (writes[i].len)
+			order.push_back(static_cast<uint32_t>(i));
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+		return writes[a].rmt_dst < writes[b].rmt_dst;
+	});
+
+	struct Span {
+		byte* start;
+		byte* end;
+		size_t first;  // Into order.
+		size_t count;
+		size_t covered;  // Bytes of the span that are written, less than end - start if there are gaps.
+	};
+	std::vector<Span> spans;
+	for (size_t i = 0; i < order.size(); i++) {
+		PendingWrite& write = writes[order[i]];
+		byte* write_end = write.rmt_dst + write.len;
+		if (!spans.empty() && write.rmt_dst <= spans.back().end + max_gap) {
+			Span& span = spans.back();
+			if (write_end > span.end) {
+				span.covered += write_end - max(write.rmt_dst, span.end);
+				span.end = write_end;
+			}
+			span.count++;
+		} else {
+			Span span = { write.rmt_dst, write_end, i, 1, write.len };
+			spans.push_back(span);
+		}
+	}
+
+	// 2. Make every page under the spans writable, one VirtualProtectEx per run of pages with the same protection.
+	struct PageRun {
+		byte* start;
+		byte* end;
+		DWORD protect;    // Original protection.
+		bool changed;
+	};
+	std::vector<PageRun> runs;
+	DWORD page_size = pageSize();
+	MEMORY_BASIC_INFORMATION mbi;
+	memset(&mbi, 0, sizeof(mbi));
+	for (size_t i = 0; i < spans.size(); i++) {
+		byte* page = reinterpret_cast<byte*>(reinterpret_cast<uint32_t>(spans[i].start) & ~(page_size - 1));
+		byte* pages_end = reinterpret_cast<byte*>((reinterpret_cast<uint32_t>(spans[i].end) + page_size - 1) & ~(page_size - 1));
+		if (!runs.empty() && runs.back().end > page)
+			page = runs.back().end;  // Page shared with the previous span.
+
+		while (page < pages_end) {
+			if (page < mbi.BaseAddress || page >= static_cast<byte*>(mbi.BaseAddress) + mbi.RegionSize) {
+				syscall_count++;
+				if (!VirtualQueryEx(handle, page, &mbi, sizeof(mbi)))
+					break;
+			}
+
+			byte* run_end = min(static_cast<byte*>(mbi.BaseAddress) + mbi.RegionSize, pages_end);
+			if (!runs.empty() && runs.back().end == page && runs.back().protect == mbi.Protect) {
+				runs.back().end = run_end;
+			} else {
+				PageRun run = { page, run_end, mbi.Protect, false };
+				runs.push_back(run);
+			}
+			page = run_end;
+		}
+	}
+
+	for (size_t i = 0; i < runs.size(); i++) {
+		DWORD writable = writableProtection(runs[i].protect);
+		DWORD oldprot;
+		if (writable) {
+			syscall_count++;
+			runs[i].changed = VirtualProtectEx(handle, runs[i].start, runs[i].end - runs[i].start, writable, &oldprot) != 0;
+		}
+	}
+
+	// 3. Save what hooks overwrite.
+	std::vector<ReadEntry> hook_reads;
+	std::vector<size_t> hook_index;
+	for (size_t i = 0; i < writes.size(); i++) {
+		if (writes[i].oldmem) {
+			ReadEntry entry = { writes[i].rmt_dst, writes[i].len, writes[i].oldmem, false };
+			hook_reads.push_back(entry);
+			hook_index.push_back(i);
+		}
+	}
+
+	std::vector<bool> skip(writes.size(), false);
+	if (!hook_reads.empty()) {
+		readBatch(handle, hook_reads);
+		syscall_count += static_cast<uint32_t>(hook_reads.size());  // Upper bound, reads get merged.
+		for (size_t i = 0; i < hook_reads.size(); i++)
+			skip[hook_index[i]] = !hook_reads[i].ok;
+	}
+
+	// 4. Write every span.
+	std::vector<byte> span_buf;
+	for (size_t i = 0; i < spans.size(); i++) {
+		Span& span = spans[i];
+		bool merged = span.count > 1;
+		bool skipped = false;
+		for (size_t j = span.first; j < span.first + span.count; j++)
+			skipped = skipped || skip[order[j]];
+		if (merged) {
+			span_buf.resize(span.end - span.start);
+			// A skipped hook's bytes are left as they are, like gaps.
+			if (span.covered < span_buf.size() || skipped) {
+				syscall_count++;
+				merged = ReadProcessMemory(handle, span.start, &span_buf[0], span_buf.size(), 0) != 0;
+			}
+		}
+
+		// Apply in the order the writes were added so later ones win, whether merged or one by one.
+		std::vector<uint32_t> members(order.begin() + span.first, order.begin() + span.first + span.count);
+		std::sort(members.begin(), members.end());
+		if (merged) {
+			for (size_t j = 0; j < members.size(); j++) {
+				PendingWrite& write = writes[members[j]];
+				if (!skip[members[j]])
+					memcpy(&span_buf[write.rmt_dst - span.start], &data[write.data_offset], write.len);
+			}
+
+			syscall_count++;
+			bool written = WriteProcessMemory(handle, span.start, &span_buf[0], span_buf.size(), 0) != 0;
+			for (size_t j = 0; j < members.size(); j++)
+				results[members[j]].ok = written && !skip[members[j]];
+		} else {
+			for (size_t j = 0; j < members.size(); j++) {
+				PendingWrite& write = writes[members[j]];
+				if (skip[members[j]])
+					continue;
+				syscall_count++;
+				results[members[j]].ok = WriteProcessMemory(handle, write.rmt_dst, &data[write.data_offset], write.len, 0) != 0;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < runs.size(); i++) {
+		DWORD oldprot;
+		if (runs[i].changed) {
+			syscall_count++;
+			VirtualProtectEx(handle, runs[i].start, runs[i].end - runs[i].start, runs[i].protect, &oldprot);
+		}
+		if (runs[i].protect & PAGE_ANYEXECUTE) {
+			syscall_count++;
+			FlushInstructionCache(handle, runs[i].start, runs[i].end - runs[i].start);
+		}
+	}
+
+	size_t ok_count = 0;
+	for (size_t i = 0; i < writes.size(); i++) {
+		if (writes[i].free_after)
+			free(writes[i].free_after);
+		if (!results[i].ok && results[i].oldmem) {
+			free(results[i].oldmem);
+			results[i].oldmem = 0;
+		}
+		ok_count += results[i].ok;
+	}
+
+	writes.clear();
+	data.clear();
+	return ok_count;
+}
+
+// Number of pages whose working set state is queried at once by walkRegions.
+#define RESIDENT_QUERY_PAGES 4096
+
+// Read [rmt_addr, rmt_end) in chunks and hand them to a walkRegions callback.
+// Returns true if the callback stopped the walk.
+static bool walkSpan(HANDLE rmt_handle, byte* local_buf, byte* rmt_addr, byte* rmt_end, size_t overlap, const Memory::Remote::RegionCallback& callback) {
+	for (byte* chunk_addr = rmt_addr; chunk_addr < rmt_end; chunk_addr += SCAN_CHUNK_SIZE) {
+		size_t chunk_size = min(static_cast<size_t>(rmt_end - chunk_addr), SCAN_CHUNK_SIZE + overlap);
+		if (ReadProcessMemory(rmt_handle, chunk_addr, local_buf, chunk_size, 0) && callback(local_buf, chunk_size, chunk_addr))
+			return true;
+		if (chunk_addr + chunk_size == rmt_end)
+			break;
+	}
+
+	return false;
+}
+
+// Walk only the pages of [rmt_addr, rmt_end) that are in the working set of the process, one run of
+// consecutive resident pages at a time.
+// Falls back to walking the whole span if the working set can't be queried.
+static bool walkResidentSpan(HANDLE rmt_handle, byte* local_buf, byte* rmt_addr, byte* rmt_end, size_t overlap, const Memory::Remote::RegionCallback& callback) {
+	DWORD page_size = pageSize();
+	std::vector<PSAPI_WORKING_SET_EX_INFORMATION> pages;
+	byte* run_start = 0;
+	byte* page = reinterpret_cast<byte*>(reinterpret_cast<uint32_t>(rmt_addr) & ~(page_size - 1));
+	while (page < rmt_end) {
+		size_t count = min(static_cast<size_t>((rmt_end - page + page_size - 1) / page_size), static_cast<size_t>(RESIDENT_QUERY_PAGES));
+		pages.resize(count);
+		for (size_t i = 0; i < count; i++)
+			pages[i].VirtualAddress = page + i * page_size;
+		if (!QueryWorkingSetEx(rmt_handle, &pages[0], static_cast<DWORD>(count * sizeof(PSAPI_WORKING_SET_EX_INFORMATION))))
+			return walkSpan(rmt_handle, local_buf, run_start ? run_start : max(page, rmt_addr), rmt_end, overlap, callback);
+
+		for (size_t i = 0; i < count; i++, page += page_size) {
+			if (pages[i].VirtualAttributes.Valid) {
+				if (!run_start)
+					run_start = max(page, rmt_addr);
+			} else if (run_start) {
+				if (walkSpan(rmt_handle, local_buf, run_start, page, overlap, callback))
+					return true;
+				run_start = 0;
+			}
+		}
+	}
+
+	return run_start && walkSpan(rmt_handle, local_buf, run_start, rmt_end, overlap, callback);
+}
+
+// Read every region of a remote process matching mem_type and mem_prot in chunks and hand them to a callback.
+// Each region is read SCAN_CHUNK_SIZE bytes at a time into one reused (pooled) local buffer, and consecutive chunks
+// share overlap bytes so that a pattern of (overlap + 1) bytes that straddles a chunk boundary is still seen
+// whole by the callback. Chunks never span two regions.
+// If mem_type includes SCAN_RESIDENT_ONLY, pages that aren't in the working set of the process (paged out,
+// or committed but never touched) are skipped instead of being faulted in by the read. Chunks then never
+// span a skipped page either.
+// The callback receives the local buffer, how many bytes of it are valid, and the remote address the buffer
+// was read from. If it returns true the walk stops early.
+// Returns true if the walk was stopped by the callback.
+bool Memory::Remote::walkRegions(HANDLE rmt_handle, byte* rmt_scan_addr, byte* rmt_end_addr, uint32_t mem_type, uint32_t mem_prot, size_t overlap, const RegionCallback& callback) {
+	MEMORY_BASIC_INFORMATION mbi;
+	Memory::LocalBuffer chunk(SCAN_CHUNK_SIZE + overlap);
+	byte* local_buf = chunk.data();
+	if (!local_buf)
+		return false;
+
+	bool stopped = false;
+	while (!stopped && VirtualQueryEx(rmt_handle, rmt_scan_addr, &mbi, sizeof(mbi)) && rmt_scan_addr < rmt_end_addr) {
+		byte* region_end = static_cast<byte*>(mbi.BaseAddress) + mbi.RegionSize;
+		if (mbi.State & MEM_COMMIT && mbi.Type & mem_type && mbi.Protect & mem_prot) {
+			if (mem_type & SCAN_RESIDENT_ONLY)
+				stopped = walkResidentSpan(rmt_handle, local_buf, rmt_scan_addr, region_end, overlap, callback);
+			else
+				stopped = walkSpan(rmt_handle, local_buf, rmt_scan_addr, region_end, overlap, callback);
+		}
+		rmt_scan_addr = region_end;
+	}
+
+	return stopped;
+}
+
+// Query every region of a remote process and keep the committed ones.
+// Returns false if not a single region could be queried (e.g. the handle lacks PROCESS_QUERY_INFORMATION).
+bool Memory::Remote::RegionMap::refresh(HANDLE rmt_handle) {
+	MEMORY_BASIC_INFORMATION mbi;
+	byte* rmt_addr = 0;
+	committed.clear();
+	taken_at = GetTickCount();
+
+	bool queried = false;
+	while (VirtualQueryEx(rmt_handle, rmt_addr, &mbi, sizeof(mbi))) {
+		queried = true;
+		if (mbi.State == MEM_COMMIT)
+			committed.push_back(mbi);
+
+		byte* region_end = static_cast<byte*>(mbi.BaseAddress) + mbi.RegionSize;
+		if (region_end <= rmt_addr)
+			break;
+		rmt_addr = region_end;
+	}
+
+	return queried;
+}
+
+const MEMORY_BASIC_INFORMATION* Memory::Remote::RegionMap::find(const void* rmt_addr) const {
+	auto it = std::upper_bound(committed.begin(), committed.end(), rmt_addr, [](const void* addr, const MEMORY_BASIC_INFORMATION& mbi) {
+		return addr < mbi.BaseAddress;
+	});
+	if (it == committed.begin())
+		return 0;
+
+	--it;
+	if (static_cast<const byte*>(rmt_addr) >= static_cast<const byte*>(it->BaseAddress) + it->RegionSize)
+		return 0;
+	return &*it;
+}
+
+// Whether every byte of a span lies in committed regions with one of the mem_prot protections.
+// Spans may cross into the next region as long as there is no gap between them.
+bool Memory::Remote::RegionMap::spanHasProt(const void* rmt_addr, size_t len, uint32_t mem_prot) const {
+	const MEMORY_BASIC_INFORMATION* mbi = find(rmt_addr);
+	const byte* span_end = static_cast<const byte*>(rmt_addr) + len;
+	while (mbi) {
+		if (!(mbi->Protect & mem_prot) || mbi->Protect & PAGE_GUARD)
+			return false;
+
+		const byte* region_end = static_cast<const byte*>(mbi->BaseAddress) + mbi->RegionSize;
+		if (span_end <= region_end)
+			return true;
+
+		mbi++;
+		if (mbi == committed.data() + committed.size() || mbi->BaseAddress != region_end)
+			return false;
+	}
+
+	return false;
+}
+
+bool Memory::Remote::RegionMap::readable(const void* rmt_addr, size_t len) const {
+	return spanHasProt(rmt_addr, len, PAGE_ANYREAD);
+}
+
+bool Memory::Remote::RegionMap::writable(const void* rmt_addr, size_t len) const {
+	return spanHasProt(rmt_addr, len, PAGE_ANYWRITE);
+}
+
 // Scan memory of a remote process.
 // rmt_scan_addr and rmt_end_addr denote the start and end (remote) addresses of the scan.
 // data points to a (local) buffer containing the data to scan for.
 // mask is a (local) c string where each character represents a byte in the data buffer to compare to the scan region.
 //   If the character is anything other than an "x" then it is considered to be a wildcard and not compared to the data buffer.
 // mem_type is a constant representing the type of memory pages to scan. Can be MEM_IMAGE, MEM_MAPPED, MEM_PRIVATE, or MEM_ANY.
+//   Or in SCAN_RESIDENT_ONLY to skip pages that aren't resident in the target (see walkRegions).
 // mem_prot is one of microsoft's memory protection constants representing the protection type of pages to scan.
 //   There are some custom values for ease of use, such as PAGE_ANYREAD, PAGE_ANYWRITE, and PAGE_ANYEXECUTE.
 void* Memory::Remote::scan(HANDLE rmt_handle, byte* rmt_scan_addr, byte* rmt_end_addr, char* data, char* mask, uint32_t mem_type, uint32_t mem_prot) {
-	MEMORY_BASIC_INFORMATION mbi;
+	size_t pattern_len = strlen(mask);
+	if (!pattern_len)
+		return 0;
 
-	while (VirtualQueryEx(rmt_handle, rmt_scan_addr, &mbi, sizeof(mbi)) && rmt_scan_addr < rmt_end_addr) {
-		if (mbi.State & MEM_COMMIT && mbi.Type & mem_type && mbi.Protect & mem_prot) {
-			size_t scan_size = mbi.RegionSize - (reinterpret_cast<uint32_t>(rmt_scan_addr) - reinterpret_cast<uint32_t>(mbi.BaseAddress));
-			byte* local_scan_start = static_cast<byte*>(allocReadData(rmt_handle, rmt_scan_addr, scan_size));
-			if (local_scan_start) {
-				byte* found = basicScan(local_scan_start, local_scan_start + scan_size, data, mask);
-				if (found)
-					return found - local_scan_start + rmt_scan_addr;
-			}
-			VirtualFree(local_scan_start, 0, MEM_RELEASE);
-		}
-		rmt_scan_addr = static_cast<byte*>(mbi.BaseAddress) + mbi.RegionSize;
-	}
+	byte* result = 0;
+	walkRegions(rmt_handle, rmt_scan_addr, rmt_end_addr, mem_type, mem_prot, pattern_len - 1, [&](byte* local_buf, size_t len, byte* rmt_addr) {
+		if (len < pattern_len)
+			return false;
 
-	return 0;
+		byte* found = basicScan(local_buf, local_buf + len - pattern_len + 1, data, mask);
+		if (found)
+			result = found - local_buf + rmt_addr;
+		return found != 0;
+	});
+
+	return result;
 }
 
 // Create a duplicate of a remote function within the remote process.
@@ -1,6 +1,8 @@
 #pragma once
 #include <stdint.h>
 #include <Windows.h>
+#include <functional>
+#include <vector>
 
 // Various constant shorthands
 #define PAGE_ANYREAD     (PAGE_READONLY | PAGE_READWRITE | PAGE_EXECUTE_READ | PAGE_EXECUTE_READWRITE)
@@ -8,6 +10,18 @@
 #define PAGE_ANYEXECUTE  (PAGE_EXECUTE | PAGE_EXECUTE_READ | PAGE_EXECUTE_READWRITE)
 #define MEM_ANY          (MEM_IMAGE | MEM_MAPPED | MEM_PRIVATE)
 
+// Or into the mem_type of a remote scan to skip pages that aren't resident in the target's working set.
+#define SCAN_RESIDENT_ONLY  0x80000000
+
+// Size of the chunks remote regions get read in when they are scanned.
+#define SCAN_CHUNK_SIZE  0x100000
+
+// readBatch merges reads whose ranges are at most this many bytes apart into one ReadProcessMemory call.
+#define READ_BATCH_GAP   0x200
+
+// Largest span a single merged read of readBatch covers.
+#define READ_BATCH_MAX   0x10000
+
 namespace Memory {
 	namespace Local {
 		// Free all of the given pointers with VirtualFree.
@@ -77,9 +91,25 @@ namespace Memory {
 		// Retrieve the PID of a process from the name of its executable file.
 		uint32_t getPid(const char* exe_name);
 
+		// Retrieve the PIDs of every process whose executable file has the given name.
+		std::vector<uint32_t> getPids(const char* exe_name);
+
 		// Retrieve the base address of a module in a remote process by pid.
 		uint32_t getModBase(uint32_t pid, const char* mod_name);
 
+		// Information identifying a module loaded in a remote process.
+		// Two modules with the same name, size, timestamp and checksum are the same build.
+		struct ModuleInfo {
+			uint32_t base;
+			uint32_t size;
+			uint32_t timestamp;
+			uint32_t checksum;
+			char name[256];
+		};
+
+		// Retrieve the base address and build identity of a module in a remote process.
+		bool getModInfo(HANDLE rmt_handle, const char* mod_name, ModuleInfo* info);
+
 		// Free all of the given (remote) pointers with VirtualFreeEx.
 		template <typename T>
 		void freeAll(HANDLE rmt_handle, T mem) {
@@ -155,6 +185,7 @@ namespace Memory {
 		}
 
 		// Allocate remote space for and write local string to remote process.
+		// Every call allocates new memory, strings that get written repeatedly belong in a Memory::StringPool.
 		inline char* allocWriteString(HANDLE rmt_handle, const char* local_src) {
 			return reinterpret_cast<char*>(allocWrite(rmt_handle, const_cast<char*>(local_src), strlen(const_cast<char*>(local_src)), PAGE_READWRITE));
 		}
@@ -195,6 +226,135 @@ namespace Memory {
 		// Allocate local space for and read string from remote process.
 		char* allocReadString(HANDLE rmt_handle, void* rmt_src);
 
+		// One read of a readBatch call.
+		struct ReadEntry {
+			void* rmt_src;
+			size_t len;
+			void* local_dst;
+			bool ok;  // Set by readBatch.
+		};
+
+		// Read many (remote) ranges into local buffers with as few ReadProcessMemory calls as possible.
+		size_t readBatch(HANDLE rmt_handle, ReadEntry* entries, size_t count, size_t max_gap = READ_BATCH_GAP);
+
+		// One write of a RemoteBackend::writeBatch call.
+		struct WriteEntry {
+			void* rmt_dst;
+			size_t len;
+			const void* local_src;
+			bool ok;  // Set by writeBatch.
+		};
+
+		// Read many (remote) ranges into local buffers with as few ReadProcessMemory calls as possible.
+		inline size_t readBatch(HANDLE rmt_handle, std::vector<ReadEntry>& entries, size_t max_gap = READ_BATCH_GAP) {
+			return entries.empty() ? 0 : readBatch(rmt_handle, &entries[0], entries.size(), max_gap);
+		}
+
+		// Collects writes to a remote process and applies them together.
+		// Writes are merged into spans and page protection is changed once per run of pages instead of
+		// once per write, so e.g. placing 500 hooks costs a handful of VirtualProtectEx calls.
+		class WriteBatch {
+		public:
+			// max_gap lets writes up to that many bytes apart be merged into one WriteProcessMemory call,
+			// with the bytes between them read first and written back unchanged. Only use it for memory the
+			// target doesn't write to itself (e.g. code), a change in a gap during the commit would be lost.
+			explicit WriteBatch(HANDLE rmt_handle, size_t max_gap = 0);
+			~WriteBatch();
+
+			WriteBatch(const WriteBatch&) = delete;
+			WriteBatch& operator=(const WriteBatch&) = delete;
+
+			// Queue a write of len bytes, the data is copied. Returns the index of the write.
+			size_t add(void* rmt_dst, const void* local_src, size_t len);
+
+			// Queue a hook, same as Memory::Remote::placeHook. Returns the index of the write.
+			// After commit() the oldmem to unhook it with is available from oldmem(index).
+			size_t addHook(void* rmt_target, void* rmt_hook);
+
+			// Queue an unhook, same as Memory::Remote::revertHook. oldmem is freed by commit().
+			size_t addRevertHook(void* rmt_target, void* oldmem);
+
+			// Apply every queued write, in order where they overlap. Returns the number of writes that worked.
+			// The queue is emptied, but results stay available until the next add.
+			size_t commit();
+
+			// Whether a write of the last commit worked.
+			bool ok(size_t index) const { return index < results.size() && results[index].ok; }
+
+			// oldmem of a hook of the last commit, or 0 if it didn't work. Ownership passes to the caller.
+			void* oldmem(size_t index);
+
+			// Number of queued writes.
+			size_t size() const { return writes.size(); }
+
+			// Number of system calls the last commit made (reading hook bytes counts as one per hook, at most).
+			uint32_t syscalls() const { return syscall_count; }
+
+		private:
+			struct PendingWrite {
+				byte* rmt_dst;
+				size_t len;
+				size_t data_offset;  // Into data.
+				void* oldmem;        // For hooks, filled with the original bytes by commit().
+				void* free_after;    // For unhooks, oldmem to free after the commit.
+			};
+
+			struct WriteResult {
+				bool ok;
+				void* oldmem;
+			};
+
+			HANDLE handle;
+			size_t max_gap;
+			std::vector<byte> data;
+			std::vector<PendingWrite> writes;
+			std::vector<WriteResult> results;
+			uint32_t syscall_count;
+
+			void releaseResults();
+		};
+
+		// Callback for walkRegions.
+		// Receives a local copy of a chunk of remote memory and the remote address it was read from.
+		// Return true to stop the walk.
+		typedef std::function<bool(byte* local_buf, size_t len, byte* rmt_addr)> RegionCallback;
+
+		// Read every region of a remote process matching mem_type and mem_prot in chunks and hand them to a callback.
+		bool walkRegions(HANDLE rmt_handle, byte* rmt_start_addr, byte* rmt_end_addr, uint32_t mem_type, uint32_t mem_prot, size_t overlap, const RegionCallback& callback);
+
+		// Cached snapshot of the committed regions of a remote process.
+		// Classifies addresses with a binary search instead of a VirtualQueryEx call each.
+		// The snapshot only changes when refresh() is called.
+		class RegionMap {
+		public:
+			RegionMap() : taken_at(0) {}
+			explicit RegionMap(HANDLE rmt_handle) : taken_at(0) { refresh(rmt_handle); }
+
+			// Query every region of the process again. Returns false if nothing could be queried.
+			bool refresh(HANDLE rmt_handle);
+
+			// Committed region containing a (remote) address, or 0.
+			const MEMORY_BASIC_INFORMATION* find(const void* rmt_addr) const;
+
+			// Whether [rmt_addr, rmt_addr + len) is committed, readable and not a guard page.
+			bool readable(const void* rmt_addr, size_t len = 1) const;
+
+			// Whether [rmt_addr, rmt_addr + len) is committed and writable.
+			bool writable(const void* rmt_addr, size_t len = 1) const;
+
+			// Committed regions in address order.
+			const std::vector<MEMORY_BASIC_INFORMATION>& regions() const { return committed; }
+
+			// Milliseconds since the last refresh().
+			DWORD age() const { return GetTickCount() - taken_at; }
+
+		private:
+			std::vector<MEMORY_BASIC_INFORMATION> committed;
+			DWORD taken_at;
+
+			bool spanHasProt(const void* rmt_addr, size_t len, uint32_t mem_prot) const;
+		};
+
 		// TODO: make more organized templates for the scanners jeeesus
 		// (can't believe I'm const casting data and mask args 90% of the time I use the scanners...)
 
@@ -0,0 +1,318 @@
+#include "win32mirror.hpp"
+
+#include <algorithm>
+#include <chrono>
+
+// Hash of a page that was never read, and of one that couldn't be read.
+#define MIRROR_HASH_NONE        0
+#define MIRROR_HASH_UNREADABLE  1
+
+// 64 bit hash of a page, four independent lanes so it runs at about memory speed.
+// Never returns MIRROR_HASH_NONE or MIRROR_HASH_UNREADABLE.
+static uint64_t hashPage(const byte* data, size_t len) {
+	const uint64_t prime = 0x9E3779B97F4A7C15ull;
+	uint64_t lanes[4] = { 1, 2, 3, 4 };
+	size_t i = 0;
+	for (; i + 32 <= len; i += 32) {
+		for (int l = 0; l < 4; l++) {
+			uint64_t word;
+			memcpy(&word, data + i + l * 8, 8);
+			lanes[l] = (lanes[l] ^ word) * prime;
+			lanes[l] ^= lanes[l] >> 29;
+		}
+	}
+	uint64_t hash = lanes[0] ^ (lanes[1] << 1) ^ (lanes[2] << 2) ^ (lanes[3] << 3);
+	for (; i < len; i++)
+		hash = (hash ^ data[i]) * prime;
+	hash ^= hash >> 32;
+	return hash > MIRROR_HASH_UNREADABLE ? hash : hash + 2;
+}
+
+// ------------------------
+// MIRROR SNAPSHOT
+// ------------------------
+
+const Memory::MirrorSnapshot::Region* Memory::MirrorSnapshot::find(uint32_t rmt_addr) const {
+	auto it = std::upper_bound(regions.begin(), regions.end(), rmt_addr, [](uint32_t addr, const Region& r) { return addr < r.base; });
+	if (it == regions.begin())
+		return 0;
+	--it;
+	return rmt_addr - it->base < it->size ? &*it : 0;
+}
+
+bool Memory::MirrorSnapshot::read(uint32_t rmt_src, void* local_dst, size_t len) const {
+	byte* dst = static_cast<byte*>(local_dst);
+	while (len) {
+		const Region* region = find(rmt_src);
+		if (!region)
+			return false;
+
+		uint32_t offset = rmt_src - region->base;
+		const byte* chunk = region->chunks[offset / MIRROR_CHUNK_SIZE].get();
+		if (!chunk)
+			return false;
+
+		// The last chunk of a region only has the region's bytes, the rest is looked up again.
+		size_t part = min(len, min(MIRROR_CHUNK_SIZE - offset % MIRROR_CHUNK_SIZE, region->size - offset));
+		memcpy(dst, chunk + offset % MIRROR_CHUNK_SIZE, part);
+		dst += part;
+		rmt_src += static_cast<uint32_t>(part);
+		len -= part;
+	}
+	return true;
+}
+
+const byte* Memory::MirrorSnapshot::data(uint32_t rmt_addr, size_t len) const {
+	const Region* region = find(rmt_addr);
+	if (!region)
+		return 0;
+
+	uint32_t offset = rmt_addr - region->base;
+	if (offset % MIRROR_CHUNK_SIZE + len > MIRROR_CHUNK_SIZE || offset + len > region->size)
+		return 0;
+	const byte* chunk = region->chunks[offset / MIRROR_CHUNK_SIZE].get();
+	return chunk ? chunk + offset % MIRROR_CHUNK_SIZE : 0;
+}
+
+// ------------------------
+// REGION MIRROR
+// ------------------------
+
+Memory::RegionMirror::RegionMirror(RemoteBackend* backend) : backend(backend), next_id(0), stopping(false), interval(0) {
+	MirrorSnapshot* empty = new MirrorSnapshot();
+	empty->snapshot_version = 0;
+	empty->changed = 0;
+	current.reset(empty);
+	resetStats();
+}
+
+Memory::RegionMirror::~RegionMirror() {
+	stop();
+}
+
+size_t Memory::RegionMirror::add(uint32_t rmt_start, size_t len) {
+	uint32_t first = rmt_start & ~(MIRROR_PAGE_SIZE - 1);
+	uint64_t end = (static_cast<uint64_t>(rmt_start) + max(len, static_cast<size_t>(1)) + MIRROR_PAGE_SIZE - 1) & ~static_cast<uint64_t>(MIRROR_PAGE_SIZE - 1);
+	end = min(end, static_cast<uint64_t>(UINT32_MAX) + 1 - MIRROR_PAGE_SIZE);
+
+	std::lock_guard<std::mutex> lock(change_lock);
+	Tracked region;
+	region.id = next_id++;
+	region.base = first;
+	region.size = static_cast<uint32_t>(end - first);
+	region.hashes.assign(region.size / MIRROR_PAGE_SIZE, MIRROR_HASH_NONE);
+	added.push_back(region);
+	return region.id;
+}
+
+void Memory::RegionMirror::remove(size_t id) {
+	std::lock_guard<std::mutex> lock(change_lock);
+	removed.push_back(id);
+}
+
+// Apply waiting adds and removes to the tracked regions and to the regions of the next version.
+// Returns whether anything changed.
+bool Memory::RegionMirror::rebuild(MirrorSnapshot& next) {
+	std::vector<Tracked> new_added;
+	std::vector<size_t> new_removed;
+	{
+		std::lock_guard<std::mutex> lock(change_lock);
+		if (added.empty() && removed.empty())
+			return false;
+		new_added.swap(added);
+		new_removed.swap(removed);
+	}
+
+	std::sort(new_removed.begin(), new_removed.end());
+	std::vector<Tracked> kept;
+	std::vector<MirrorSnapshot::Region> kept_regions;
+	for (size_t i = 0; i < regions.size(); i++) {
+		if (std::binary_search(new_removed.begin(), new_removed.end(), regions[i].id))
+			continue;
+		kept.push_back(regions[i]);
+		kept_regions.push_back(next.regions[i]);
+	}
+	for (size_t i = 0; i < new_added.size(); i++) {
+		if (std::binary_search(new_removed.begin(), new_removed.end(), new_added[i].id))
+			continue;
+		MirrorSnapshot::Region region = { new_added[i].id, new_added[i].base, new_added[i].size };
+		region.chunks.resize((region.size + MIRROR_CHUNK_SIZE - 1) / MIRROR_CHUNK_SIZE);
+		kept.push_back(new_added[i]);
+		kept_regions.push_back(region);
+	}
+
+	// Both lists get sorted the same way, by base then id.
+	std::vector<size_t> order(kept.size());
+	for (size_t i = 0; i < order.size(); i++)
+		order[i] = i;
+	std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return kept[a].base != kept[b].base ? kept[a].base < kept[b].base : kept[a].id < kept[b].id; });
+	regions.clear();
+	next.regions.clear();
+	for (size_t i = 0; i < order.size(); i++) {
+		regions.push_back(kept[order[i]]);
+		next.regions.push_back(kept_regions[order[i]]);
+	}
+	return true;
+}
+
+// Read the chunks of the batch into the scratch buffer, retrying failed chunks page by page, then compare
+// page hashes and copy chunks with a changed page into the next version. Returns the number of changed pages.
+size_t Memory::RegionMirror::readBatch(MirrorSnapshot& next) {
+	reads.clear();
+	for (size_t i = 0; i < batch.size(); i++) {
+		Memory::Remote::ReadEntry read = { reinterpret_cast<void*>(regions[batch[i].region].base + static_cast<uint32_t>(batch[i].chunk) * MIRROR_CHUNK_SIZE), batch[i].len, &scratch[batch[i].offset], false };
+		reads.push_back(read);
+	}
+	backend->readBatch(&reads[0], reads.size());
+
+	// Chunks that couldn't be read whole may still have readable pages.
+	std::vector<Memory::Remote::ReadEntry> page_reads;
+	for (size_t i = 0; i < batch.size(); i++) {
+		if (reads[i].ok)
+			continue;
+		for (uint32_t page = 0; page < batch[i].len; page += MIRROR_PAGE_SIZE) {
+			Memory::Remote::ReadEntry read = { static_cast<byte*>(reads[i].rmt_src) + page, MIRROR_PAGE_SIZE, &scratch[batch[i].offset + page], false };
+			page_reads.push_back(read);
+		}
+	}
+	if (!page_reads.empty())
+		backend->readBatch(&page_reads[0], page_reads.size());
+
+	size_t changed = 0;
+	size_t failures = 0;
+	size_t copied = 0;
+	size_t page_read = 0;
+	for (size_t i = 0; i < batch.size(); i++) {
+		Tracked& tracked = regions[batch[i].region];
+		MirrorSnapshot::Region& region = next.regions[batch[i].region];
+		const byte* data = &scratch[batch[i].offset];
+		size_t first_page = batch[i].chunk * (MIRROR_CHUNK_SIZE / MIRROR_PAGE_SIZE);
+		bool chunk_changed = !region.chunks[batch[i].chunk];
+		size_t chunk_failures = 0;
+		for (uint32_t page = 0; page < batch[i].len; page += MIRROR_PAGE_SIZE) {
+			uint64_t hash;
+			if (reads[i].ok || page_reads[page_read++].ok) {
+				hash = hashPage(data + page, MIRROR_PAGE_SIZE);
+			} else {
+				hash = MIRROR_HASH_UNREADABLE;
+				memset(&scratch[batch[i].offset + page], 0, MIRROR_PAGE_SIZE);
+				chunk_failures++;
+			}
+
+			uint64_t& old_hash = tracked.hashes[first_page + page / MIRROR_PAGE_SIZE];
+			if (hash != old_hash) {
+				if (old_hash != MIRROR_HASH_NONE)
+					changed++;
+				old_hash = hash;
+				chunk_changed = true;
+			}
+		}
+
+		failures += chunk_failures;
+		if (!chunk_changed)
+			continue;
+		if (chunk_failures == batch[i].len / MIRROR_PAGE_SIZE) {
+			region.chunks[batch[i].chunk].reset();
+			continue;
+		}
+		byte* copy = new byte[batch[i].len];
+		memcpy(copy, data, batch[i].len);
+		region.chunks[batch[i].chunk].reset(copy, std::default_delete<byte[]>());
+		copied++;
+	}
+
+	std::lock_guard<std::mutex> lock(stats_lock);
+	mirror_stats.chunks_copied += copied;
+	mirror_stats.read_failures += failures;
+	return changed;
+}
+
+// The next version starts as a copy of the current one, which only copies chunk pointers. Chunks get
+// replaced in it as they are found changed, and it is published once every region has been read.
+size_t Memory::RegionMirror::sync() {
+	std::lock_guard<std::mutex> lock(sync_lock);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+	std::shared_ptr<const MirrorSnapshot> prev = snapshot();
+	MirrorSnapshot* next = new MirrorSnapshot(*prev);
+	std::shared_ptr<const MirrorSnapshot> published(next);
+	next->snapshot_version = prev->snapshot_version + 1;
+	rebuild(*next);
+
+	scratch.resize(MIRROR_BATCH_SIZE);
+	size_t changed = 0;
+	size_t pages = 0;
+	uint32_t used = 0;
+	batch.clear();
+	for (size_t r = 0; r < regions.size(); r++) {
+		pages += regions[r].size / MIRROR_PAGE_SIZE;
+		for (uint32_t offset = 0; offset < regions[r].size; offset += MIRROR_CHUNK_SIZE) {
+			uint32_t len = min(regions[r].size - offset, static_cast<uint32_t>(MIRROR_CHUNK_SIZE));
+			if (used + len > MIRROR_BATCH_SIZE) {
+				changed += readBatch(*next);
+				batch.clear();
+				used = 0;
+			}
+			ChunkRead chunk = { r, offset / MIRROR_CHUNK_SIZE, used, len };
+			batch.push_back(chunk);
+			used += len;
+		}
+	}
+	if (!batch.empty())
+		changed += readBatch(*next);
+
+	next->changed = changed;
+	std::atomic_store(&current, published);
+
+	double took = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+	std::lock_guard<std::mutex> stats(stats_lock);
+	mirror_stats.syncs++;
+	mirror_stats.pages = pages;
+	mirror_stats.pages_changed += changed;
+	mirror_stats.sync_last = took;
+	sync_total += took;
+	return changed;
+}
+
+void Memory::RegionMirror::start(DWORD interval_ms) {
+	if (running())
+		return;
+	interval = interval_ms;
+	stopping = false;
+	thread = std::thread(&RegionMirror::run, this);
+}
+
+void Memory::RegionMirror::stop() {
+	stopping = true;
+	if (thread.joinable())
+		thread.join();
+}
+
+// Syncs start on a fixed grid, a sync that overruns restarts the grid from its end.
+void Memory::RegionMirror::run() {
+	typedef std::chrono::steady_clock clock;
+	clock::time_point due = clock::now();
+	while (!stopping) {
+		if (clock::now() < due)
+			std::this_thread::sleep_until(due);
+		sync();
+
+		due += std::chrono::milliseconds(interval);
+		clock::time_point now = clock::now();
+		if (due < now)
+			due = now;
+	}
+}
+
+Memory::MirrorStats Memory::RegionMirror::stats() {
+	std::lock_guard<std::mutex> lock(stats_lock);
+	MirrorStats s = mirror_stats;
+	s.sync_mean = s.syncs ? sync_total / s.syncs : 0.0;
+	return s;
+}
+
+void Memory::RegionMirror::resetStats() {
+	std::lock_guard<std::mutex> lock(stats_lock);
+	memset(&mirror_stats, 0, sizeof(mirror_stats));
+	sync_total = 0.0;
+}
\ No newline at end of file
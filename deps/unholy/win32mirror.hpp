@@ -0,0 +1,164 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <Windows.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "win32backend.hpp"
+
+// Granularity changes are detected at.
+#define MIRROR_PAGE_SIZE    0x1000
+
+// Granularity mirror memory is shared between versions at.
+#define MIRROR_CHUNK_SIZE   0x10000
+
+// Bytes a sync reads with one RemoteBackend::readBatch.
+#define MIRROR_BATCH_SIZE   0x100000
+
+namespace Memory {
+	// Counters of a RegionMirror. Times are in microseconds.
+	struct MirrorStats {
+		uint64_t syncs;
+		uint64_t pages;           // Pages mirrored.
+		uint64_t pages_changed;   // Pages found changed, over all syncs.
+		uint64_t chunks_copied;   // Chunks that had to be copied into a new version, over all syncs.
+		uint64_t read_failures;   // Pages that couldn't be read, over all syncs.
+		double sync_mean;
+		double sync_last;
+	};
+
+	// One published version of the regions of a RegionMirror. Never changes once published.
+	class MirrorSnapshot {
+	public:
+		// Number of syncs this version is the result of.
+		uint64_t version() const { return snapshot_version; }
+
+		// Pages that changed since the previous version.
+		size_t changedPages() const { return changed; }
+
+		// Copy len bytes at a (remote) address out of the mirror.
+		// Returns false if any of it isn't mirrored or is in a chunk the last sync couldn't read at all.
+		// Single unreadable pages of a chunk read as zeros.
+		bool read(uint32_t rmt_src, void* local_dst, size_t len) const;
+
+		template <typename T>
+		bool read(uint32_t rmt_src, T& value) const {
+			return read(rmt_src, &value, sizeof(T));
+		}
+
+		// Value of type T at a (remote) address, T() if it isn't mirrored.
+		template <typename T>
+		T read(uint32_t rmt_src) const {
+			T value;
+			if (!read(rmt_src, &value, sizeof(T)))
+				return T();
+			return value;
+		}
+
+		// Mirrored bytes at a (remote) address, if len bytes from there are within one chunk, otherwise 0.
+		const byte* data(uint32_t rmt_addr, size_t len) const;
+
+	private:
+		friend class RegionMirror;
+
+		struct Region {
+			size_t id;
+			uint32_t base;
+			uint32_t size;
+			std::vector<std::shared_ptr<const byte>> chunks;  // 0 for chunks never read.
+		};
+
+		uint64_t snapshot_version;
+		size_t changed;
+		std::vector<Region> regions;  // Sorted by base.
+
+		const Region* find(uint32_t rmt_addr) const;
+	};
+
+	// Keeps a local copy of (remote) memory regions in sync.
+	// Each sync reads the regions in large batches, hashes every page and compares it with the hash of the
+	// previous sync. Chunks without a changed page are shared with the previous version, so only changed
+	// memory gets copied. Versions are published by swapping a shared_ptr: readers take a snapshot and keep
+	// it as long as they like, they never wait for a sync and never see one halfway done.
+	// Limitation: every sync still reads every mirrored byte out of the target, so it costs as much
+	// cross-process transfer as a full re-read. Windows has no soft-dirty bits for another process, and
+	// the hashes are computed locally after the read. The hashes only save local copies and allocations.
+	class RegionMirror {
+	public:
+		explicit RegionMirror(RemoteBackend* backend);
+		~RegionMirror();
+
+		RegionMirror(const RegionMirror&) = delete;
+		RegionMirror& operator=(const RegionMirror&) = delete;
+
+		// Mirror a (remote) range, widened to whole pages. Returns the id of the region.
+		// Can be called from any thread, it takes effect on the next sync.
+		size_t add(uint32_t rmt_start, size_t len);
+
+		// Stop mirroring a region. Takes effect on the next sync.
+		void remove(size_t id);
+
+		// Bring the mirror up to date and publish a new version. Returns the number of pages that changed.
+		size_t sync();
+
+		// Sync on a thread of its own, every interval_ms milliseconds.
+		void start(DWORD interval_ms);
+
+		// Stop the sync thread.
+		void stop();
+
+		bool running() const { return thread.joinable(); }
+
+		// Latest published version. Never 0, before the first sync it mirrors nothing.
+		std::shared_ptr<const MirrorSnapshot> snapshot() const { return std::atomic_load(&current); }
+
+		MirrorStats stats();
+		void resetStats();
+
+	private:
+		// Hashes of a region's pages as of the last sync.
+		struct Tracked {
+			size_t id;
+			uint32_t base;
+			uint32_t size;
+			std::vector<uint64_t> hashes;  // MIRROR_HASH_NONE for pages never read.
+		};
+
+		// A chunk read by the current batch.
+		struct ChunkRead {
+			size_t region;
+			size_t chunk;
+			uint32_t offset;  // Of its bytes in the scratch buffer.
+			uint32_t len;
+		};
+
+		RemoteBackend* backend;
+		std::shared_ptr<const MirrorSnapshot> current;
+		std::vector<Tracked> regions;  // Sorted by base, like the regions of the snapshots.
+		std::vector<byte> scratch;
+		std::vector<ChunkRead> batch;
+		std::vector<Memory::Remote::ReadEntry> reads;
+		std::mutex sync_lock;
+
+		// Changes to the region set waiting for the next sync.
+		std::mutex change_lock;
+		std::vector<Tracked> added;
+		std::vector<size_t> removed;
+		size_t next_id;
+
+		std::thread thread;
+		std::atomic<bool> stopping;
+		DWORD interval;
+		std::mutex stats_lock;
+		MirrorStats mirror_stats;
+		double sync_total;
+
+		bool rebuild(MirrorSnapshot& next);
+		size_t readBatch(MirrorSnapshot& next);
+		void run();
+	};
+}
\ No newline at end of file
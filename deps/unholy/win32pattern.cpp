@@ -0,0 +1,727 @@
+#include "win32pattern.hpp"
+
+#include <map>
+
+// ------------------------
+// PATTERN COMPILER
+// ------------------------
+
+// Patterns are compiled in four steps:
+//   1. The source is parsed into a small tree of byte sets, sequences, alternations and optionals.
+//      Gaps are expanded into runs of "any byte" sets, the optional tail of [n-m] as optionals.
+//   2. The tree is turned into a Glushkov automaton. Every byte set in the tree becomes one position,
+//      and the automaton is just the first/last position sets plus a follow set for every position.
+//      It has no epsilon transitions, which keeps both engines below simple.
+//   3. Bytes that appear in exactly the same positions are merged into equivalence classes, and the
+//      automaton is determinized over those classes into an unanchored forward DFA (finds where a
+//      match ends) and an anchored reverse DFA (walks back from the end to find where it starts).
+//      Both get minimized with Moore's partition refinement.
+//   4. If determinizing blows past PATTERN_MAX_DFA_STATES (long gaps in front of common bytes can do
+//      that), the pattern keeps the Glushkov automaton instead and simulates it bit-parallel, with the
+//      active positions in one 64-bit mask.
+
+// 256-bit set of byte values.
+struct ByteSet {
+	uint64_t bits[4];
+
+	ByteSet() { clear(); }
+	void clear() { bits[0] = bits[1] = bits[2] = bits[3] = 0; }
+	void setAll() { bits[0] = bits[1] = bits[2] = bits[3] = ~0ULL; }
+	void set(uint32_t c) { bits[c >> 6] |= 1ULL << (c & 63); }
+	bool test(uint32_t c) const { return (bits[c >> 6] >> (c & 63)) & 1; }
+	void unite(const ByteSet& other) { for (int i = 0; i < 4; i++) bits[i] |= other.bits[i]; }
+};
+
+// Set of automaton positions of arbitrary size.
+typedef std::vector<uint64_t> PositionSet;
+
+static inline void posSet(PositionSet& set, size_t pos) { set[pos >> 6] |= 1ULL << (pos & 63); }
+static inline bool posTest(const PositionSet& set, size_t pos) { return (set[pos >> 6] >> (pos & 63)) & 1; }
+static inline void posUnite(PositionSet& set, const PositionSet& other) { for (size_t i = 0; i < set.size(); i++) set[i] |= other[i]; }
+static inline void posIntersect(PositionSet& set, const PositionSet& other) { for (size_t i = 0; i < set.size(); i++) set[i] &= other[i]; }
+
+static inline bool posIntersects(const PositionSet& a, const PositionSet& b) {
+	for (size_t i = 0; i < a.size(); i++)
+		if (a[i] & b[i])
+			return true;
+	return false;
+}
+
+static inline bool posEmpty(const PositionSet& set) {
+	for (size_t i = 0; i < set.size(); i++)
+		if (set[i])
+			return false;
+	return true;
+}
+
+// Node of a parsed pattern.
+struct PatternNode {
+	enum Kind { NODE_SET, NODE_SEQ, NODE_ALT, NODE_OPT } kind;
+	ByteSet set;                        // NODE_SET only.
+	std::vector<PatternNode> children;  // Everything else. NODE_OPT has exactly one child.
+
+	explicit PatternNode(Kind kind) : kind(kind) {}
+};
+
+static int hexValue(char c) {
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
+
+static inline bool isAtomChar(char c) {
+	return c == '?' || hexValue(c) >= 0;
+}
+
+static inline bool isSpace(char c) {
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static inline void skipSpace(const char*& src) {
+	while (isSpace(*src))
+		src++;
+}
+
+// Parse a single byte, nibble wildcard, any byte or byte range into a set.
+static bool parseAtom(const char*& src, ByteSet& set) {
+	if (src[0] == '?' && !isAtomChar(src[1])) {
+		src++;
+		set.setAll();
+		return true;
+	}
+
+	if (!isAtomChar(src[0]) || !isAtomChar(src[1]))
+		return false;
+
+	int hi = hexValue(src[0]);
+	int lo = hexValue(src[1]);
+	src += 2;
+
+	if (hi >= 0 && lo >= 0 && src[0] == '-') {
+		int hi2 = hexValue(src[1]);
+		int lo2 = hexValue(src[2]);
+		if (hi2 < 0 || lo2 < 0)
+			return false;
+		uint32_t from = (hi << 4) | lo, to = (hi2 << 4) | lo2;
+		if (from > to)
+			return false;
+		for (uint32_t c = from; c <= to; c++)
+			set.set(c);
+		src += 3;
+		return true;
+	}
+
+	for (uint32_t c = 0; c < 256; c++)
+		if ((hi < 0 || static_cast<int>(c >> 4) == hi) && (lo < 0 || static_cast<int>(c & 15) == lo))
+			set.set(c);
+	return true;
+}
+
+// Parse a decimal number for gaps.
+static bool parseNumber(const char*& src, uint32_t& value) {
+	if (*src < '0' || *src > '9')
+		return false;
+	value = 0;
+	while (*src >= '0' && *src <= '9') {
+		value = value * 10 + (*src++ - '0');
+		if (value > PATTERN_MAX_GAP)
+			return false;
+	}
+	return true;
+}
+
+static bool parseSequence(const char*& src, PatternNode& seq, bool in_group);
+
+// Parse "(a | b c | ...)".
+static bool parseGroup(const char*& src, PatternNode& alt) {
+	src++;
+	for (;;) {
+		PatternNode seq(PatternNode::NODE_SEQ);
+		if (!parseSequence(src, seq, true))
+			return false;
+		alt.children.push_back(seq);
+
+		skipSpace(src);
+		if (*src == '|') {
+			src++;
+			continue;
+		}
+		if (*src == ')') {
+			src++;
+			return true;
+		}
+		return false;
+	}
+}
+
+// Parse "[n]" or "[n-m]" into n mandatory and m - n optional "any byte" sets.
+static bool parseGap(const char*& src, PatternNode& seq) {
+	uint32_t min_gap, max_gap;
+	src++;
+	skipSpace(src);
+	if (!parseNumber(src, min_gap))
+		return false;
+	max_gap = min_gap;
+	skipSpace(src);
+	if (*src == '-') {
+		src++;
+		skipSpace(src);
+		if (!parseNumber(src, max_gap) || max_gap < min_gap)
+			return false;
+		skipSpace(src);
+	}
+	if (*src++ != ']')
+		return false;
+
+	PatternNode any(PatternNode::NODE_SET);
+	any.set.setAll();
+	for (uint32_t i = 0; i < min_gap; i++)
+		seq.children.push_back(any);
+
+	PatternNode opt(PatternNode::NODE_OPT);
+	opt.children.push_back(any);
+	for (uint32_t i = min_gap; i < max_gap; i++)
+		seq.children.push_back(opt);
+	return true;
+}
+
+// Parse elements until the end of the source, or until a ")" or standalone "|" when inside a group.
+static bool parseSequence(const char*& src, PatternNode& seq, bool in_group) {
+	for (;;) {
+		skipSpace(src);
+		char c = *src;
+		if (!c)
+			return !in_group;
+		if (c == ')' || c == '|')
+			return in_group;
+
+		if (c == '(') {
+			PatternNode alt(PatternNode::NODE_ALT);
+			if (!parseGroup(src, alt))
+				return false;
+			seq.children.push_back(alt);
+			continue;
+		}
+
+		if (c == '[') {
+			if (!parseGap(src, seq))
+				return false;
+			continue;
+		}
+
+		// Byte set, "a|b|c" with no spaces in between.
+		PatternNode set(PatternNode::NODE_SET);
+		if (!parseAtom(src, set.set))
+			return false;
+		while (src[0] == '|' && isAtomChar(src[1])) {
+			ByteSet more;
+			src++;
+			if (!parseAtom(src, more))
+				return false;
+			set.set.unite(more);
+		}
+		if (*src && !isSpace(*src) && *src != '(' && *src != ')' && *src != '[' && *src != '|')
+			return false;
+		seq.children.push_back(set);
+	}
+}
+
+// Shortest and longest match of a node.
+static void nodeLengths(const PatternNode& node, size_t& min_len, size_t& max_len) {
+	switch (node.kind) {
+	case PatternNode::NODE_SET:
+		min_len = max_len = 1;
+		return;
+	case PatternNode::NODE_OPT:
+		nodeLengths(node.children[0], min_len, max_len);
+		min_len = 0;
+		return;
+	case PatternNode::NODE_SEQ:
+		min_len = max_len = 0;
+		for (const PatternNode& child : node.children) {
+			size_t child_min, child_max;
+			nodeLengths(child, child_min, child_max);
+			min_len += child_min;
+			max_len += child_max;
+		}
+		return;
+	case PatternNode::NODE_ALT:
+		min_len = SIZE_MAX;
+		max_len = 0;
+		for (const PatternNode& child : node.children) {
+			size_t child_min, child_max;
+			nodeLengths(child, child_min, child_max);
+			min_len = min(min_len, child_min);
+			max_len = max(max_len, child_max);
+		}
+		if (node.children.empty())
+			min_len = 0;
+		return;
+	}
+}
+
+static size_t countPositions(const PatternNode& node) {
+	if (node.kind == PatternNode::NODE_SET)
+		return 1;
+	size_t count = 0;
+	for (const PatternNode& child : node.children)
+		count += countPositions(child);
+	return count;
+}
+
+// A DFA under construction. Transitions are state ids, not row offsets yet.
+struct RawDfa {
+	std::vector<uint32_t> next;
+	std::vector<bool> accept;
+	uint32_t start;
+	uint32_t dead;  // UINT32_MAX if there is none.
+};
+
+// Does the actual work of Pattern::compile. Friend of Pattern.
+struct PatternCompiler {
+	Memory::Pattern& pattern;
+
+	size_t num_positions;
+	size_t words;
+	std::vector<ByteSet> position_bytes;
+	std::vector<PositionSet> follow;
+	std::vector<PositionSet> follow_rev;
+	PositionSet first;
+	PositionSet last;
+	std::vector<PositionSet> class_positions;  // Per class, positions whose set contains it.
+
+	explicit PatternCompiler(Memory::Pattern& pattern) : pattern(pattern), num_positions(0), words(0) {}
+
+	struct NodeInfo {
+		PositionSet first;
+		PositionSet last;
+		bool nullable;
+	};
+
+	// Glushkov construction.
+	NodeInfo build(const PatternNode& node, size_t& next_pos) {
+		NodeInfo info = { PositionSet(words), PositionSet(words), false };
+
+		switch (node.kind) {
+		case PatternNode::NODE_SET:
+			position_bytes[next_pos] = node.set;
+			posSet(info.first, next_pos);
+			posSet(info.last, next_pos);
+			next_pos++;
+			break;
+
+		case PatternNode::NODE_OPT:
+			info = build(node.children[0], next_pos);
+			info.nullable = true;
+			break;
+
+		case PatternNode::NODE_ALT:
+			for (const PatternNode& child : node.children) {
+				NodeInfo child_info = build(child, next_pos);
+				posUnite(info.first, child_info.first);
+				posUnite(info.last, child_info.last);
+				info.nullable |= child_info.nullable;
+			}
+			if (node.children.empty())
+				info.nullable = true;
+			break;
+
+		case PatternNode::NODE_SEQ:
+			info.nullable = true;
+			for (const PatternNode& child : node.children) {
+				NodeInfo child_info = build(child, next_pos);
+				for (size_t pos = 0; pos < num_positions; pos++)
+					if (posTest(info.last, pos))
+						posUnite(follow[pos], child_info.first);
+				if (info.nullable)
+					posUnite(info.first, child_info.first);
+				if (child_info.nullable)
+					posUnite(info.last, child_info.last);
+				else
+					info.last = child_info.last;
+				info.nullable &= child_info.nullable;
+			}
+			break;
+		}
+
+		return info;
+	}
+
+	// Merge bytes that appear in exactly the same positions.
+	void buildClasses() {
+		class_positions.clear();
+		for (uint32_t c = 0; c < 256; c++) {
+			PositionSet signature(words);
+			for (size_t pos = 0; pos < num_positions; pos++)
+				if (position_bytes[pos].test(c))
+					posSet(signature, pos);
+
+			uint32_t cls = 0;
+			while (cls < class_positions.size() && class_positions[cls] != signature)
+				cls++;
+			if (cls == class_positions.size())
+				class_positions.push_back(signature);
+			pattern.classes[c] = static_cast<byte>(cls);
+		}
+		pattern.num_classes = static_cast<uint32_t>(class_positions.size());
+	}
+
+	// Positions that can come after any position in set.
+	PositionSet followOf(const PositionSet& set, const std::vector<PositionSet>& table) const {
+		PositionSet result(words);
+		for (size_t pos = 0; pos < num_positions; pos++)
+			if (posTest(set, pos))
+				posUnite(result, table[pos]);
+		return result;
+	}
+
+	// Subset construction.
+	// The forward DFA restarts at "first" on every byte so it finds matches anywhere. The reverse DFA
+	// begins at "last" exactly once, which is what the extra marker bit after the real positions is for.
+	bool determinize(RawDfa& dfa, bool reverse) {
+		size_t marker = num_positions;
+		size_t key_words = (num_positions + 1 + 63) / 64;
+		std::map<PositionSet, uint32_t> ids;
+		std::vector<PositionSet> states;
+
+		PositionSet start(key_words);
+		if (reverse)
+			posSet(start, marker);
+		ids[start] = 0;
+		states.push_back(start);
+		dfa.next.clear();
+		dfa.accept.assign(1, false);
+		dfa.start = 0;
+		dfa.dead = UINT32_MAX;
+
+		const PositionSet& entry = reverse ? last : first;
+		const PositionSet& exit = reverse ? first : last;
+		const std::vector<PositionSet>& table = reverse ? follow_rev : follow;
+
+		for (size_t id = 0; id < states.size(); id++) {
+			PositionSet current = states[id];
+			current.resize(words);
+			bool at_start = reverse ? posTest(states[id], marker) : true;
+
+			PositionSet base = followOf(current, table);
+			if (at_start)
+				posUnite(base, entry);
+
+			for (uint32_t cls = 0; cls < pattern.num_classes; cls++) {
+				PositionSet next = base;
+				posIntersect(next, class_positions[cls]);
+				bool accepting = posIntersects(next, exit);
+				next.resize(key_words);
+
+				auto found = ids.find(next);
+				uint32_t next_id;
+				if (found != ids.end()) {
+					next_id = found->second;
+				} else {
+					if (states.size() >= PATTERN_MAX_DFA_STATES)
+						return false;
+					next_id = static_cast<uint32_t>(states.size());
+					ids[next] = next_id;
+					states.push_back(next);
+					dfa.accept.push_back(accepting);
+					if (reverse && posEmpty(next))
+						dfa.dead = next_id;
+				}
+				dfa.next.push_back(next_id);
+			}
+		}
+
+		return true;
+	}
+
+	// Moore partition refinement.
+	// Blocks are numbered so accepting ones come last, then rows are laid out as row offsets.
+	void minimize(const RawDfa& dfa, std::vector<uint32_t>& out, uint32_t& start, uint32_t& accept_row, uint32_t* dead) {
+		uint32_t num_classes = pattern.num_classes;
+		size_t num_states = dfa.accept.size();
+		std::vector<uint32_t> block(num_states);
+		for (size_t s = 0; s < num_states; s++)
+			block[s] = dfa.accept[s] ? 1 : 0;
+
+		size_t num_blocks = 0;
+		for (;;) {
+			std::map<std::vector<uint32_t>, uint32_t> signatures;
+			std::vector<uint32_t> new_block(num_states);
+			std::vector<uint32_t> signature(num_classes + 1);
+			for (size_t s = 0; s < num_states; s++) {
+				signature[0] = block[s];
+				for (uint32_t cls = 0; cls < num_classes; cls++)
+					signature[cls + 1] = block[dfa.next[s * num_classes + cls]];
+				auto inserted = signatures.insert({ signature, static_cast<uint32_t>(signatures.size()) });
+				new_block[s] = inserted.first->second;
+			}
+
+			block.swap(new_block);
+			if (signatures.size() == num_blocks)
+				break;
+			num_blocks = signatures.size();
+		}
+
+		// Renumber so that accepting blocks are last.
+		std::vector<uint32_t> order(num_blocks, UINT32_MAX);
+		std::vector<bool> block_accept(num_blocks);
+		for (size_t s = 0; s < num_states; s++)
+			block_accept[block[s]] = dfa.accept[s];
+
+		uint32_t next_id = 0;
+		for (int pass = 0; pass < 2; pass++) {
+			if (pass == 1)
+				accept_row = next_id * num_classes;
+			for (size_t b = 0; b < num_blocks; b++)
+				if (block_accept[b] == (pass == 1))
+					order[b] = next_id++;
+		}
+
+		out.assign(num_blocks * num_classes, 0);
+		for (size_t s = 0; s < num_states; s++)
+			for (uint32_t cls = 0; cls < num_classes; cls++)
+				out[order[block[s]] * num_classes + cls] = order[block[dfa.next[s * num_classes + cls]]] * num_classes;
+
+		start = order[block[dfa.start]] * num_classes;
+		if (dead)
+			*dead = dfa.dead == UINT32_MAX ? UINT32_MAX : order[block[dfa.dead]] * num_classes;
+	}
+
+	// Follow tables for the bit-parallel engine, one 256 entry table per byte of the position mask.
+	void buildFollowTables(std::vector<uint64_t>& out, const std::vector<PositionSet>& table) {
+		out.assign(8 * 256, 0);
+		for (size_t chunk = 0; chunk < 8; chunk++)
+			for (uint32_t value = 0; value < 256; value++)
+				for (uint32_t bit = 0; bit < 8; bit++)
+					if (value & (1 << bit) && chunk * 8 + bit < num_positions)
+						out[chunk * 256 + value] |= table[chunk * 8 + bit][0];
+	}
+
+	bool compile(const PatternNode& root) {
+		num_positions = countPositions(root);
+		words = (num_positions + 63) / 64;
+		position_bytes.assign(num_positions, ByteSet());
+		follow.assign(num_positions, PositionSet(words));
+
+		size_t next_pos = 0;
+		NodeInfo info = build(root, next_pos);
+		if (info.nullable)
+			return false;
+		first = info.first;
+		last = info.last;
+
+		follow_rev.assign(num_positions, PositionSet(words));
+		for (size_t from = 0; from < num_positions; from++)
+			for (size_t to = 0; to < num_positions; to++)
+				if (posTest(follow[from], to))
+					posSet(follow_rev[to], from);
+
+		buildClasses();
+
+		// A single possible first byte lets find() skip ahead with memchr.
+		ByteSet first_bytes;
+		for (size_t pos = 0; pos < num_positions; pos++)
+			if (posTest(first, pos))
+				first_bytes.unite(position_bytes[pos]);
+		pattern.prefilter_byte = -1;
+		for (uint32_t c = 0; c < 256; c++) {
+			if (!first_bytes.test(c))
+				continue;
+			if (pattern.prefilter_byte != -1) {
+				pattern.prefilter_byte = -1;
+				break;
+			}
+			pattern.prefilter_byte = static_cast<int>(c);
+		}
+
+		RawDfa fwd, rev;
+		if (determinize(fwd, false) && determinize(rev, true)) {
+			minimize(fwd, pattern.fwd_next, pattern.fwd_start, pattern.fwd_accept, 0);
+			minimize(rev, pattern.rev_next, pattern.rev_start, pattern.rev_accept, &pattern.rev_dead);
+			return true;
+		}
+
+		if (num_positions > PATTERN_MAX_POSITIONS)
+			return false;
+
+		pattern.fwd_next.clear();
+		pattern.rev_next.clear();
+		pattern.first_pos = first[0];
+		pattern.last_pos = last[0];
+		pattern.pos_bytes.resize(pattern.num_classes);
+		for (uint32_t cls = 0; cls < pattern.num_classes; cls++)
+			pattern.pos_bytes[cls] = class_positions[cls][0];
+		buildFollowTables(pattern.follow_fwd, follow);
+		buildFollowTables(pattern.follow_rev, follow_rev);
+		return true;
+	}
+};
+
+Memory::Pattern::Pattern() : min_len(0), max_len(0), num_classes(0), prefilter_byte(-1),
+	fwd_start(0), fwd_accept(0), rev_start(0), rev_accept(0), rev_dead(UINT32_MAX), first_pos(0), last_pos(0) {
+	memset(classes, 0, sizeof(classes));
+}
+
+// Compile pattern source (see the syntax described above the class).
+// Returns false if the source is malformed, can match the empty string, or is too big for both engines.
+bool Memory::Pattern::compile(const char* src) {
+	*this = Pattern();
+
+	PatternNode root(PatternNode::NODE_SEQ);
+	const char* cursor = src;
+	if (!parseSequence(cursor, root, false))
+		return false;
+
+	size_t root_min, root_max;
+	nodeLengths(root, root_min, root_max);
+	if (!root_min)
+		return false;
+
+	PatternCompiler compiler(*this);
+	if (!compiler.compile(root)) {
+		*this = Pattern();
+		return false;
+	}
+
+	min_len = root_min;
+	max_len = root_max;
+	return true;
+}
+
+// ------------------------
+// PATTERN MATCHING
+// ------------------------
+
+// Find the first match within a local buffer.
+// "First" is the match that ends earliest, and among matches ending there the one that starts earliest.
+// Returns the start of the match or 0, and optionally stores the length of the match in match_len.
+const byte* Memory::Pattern::find(const byte* start, const byte* end, size_t* match_len) const {
+	if (!valid() || start >= end)
+		return 0;
+	return usesDfa() ? findDfa(start, end, match_len) : findBitParallel(start, end, match_len);
+}
+
+const byte* Memory::Pattern::findDfa(const byte* start, const byte* end, size_t* match_len) const {
+	const uint32_t* fwd = fwd_next.data();
+	const uint32_t* rev = rev_next.data();
+	uint32_t state = fwd_start;
+
+	for (const byte* scan_addr = start; scan_addr < end; scan_addr++) {
+		if (state == fwd_start && prefilter_byte >= 0) {
+			scan_addr = static_cast<const byte*>(memchr(scan_addr, prefilter_byte, end - scan_addr));
+			if (!scan_addr)
+				return 0;
+		}
+
+		state = fwd[state + classes[*scan_addr]];
+		if (state < fwd_accept)
+			continue;
+
+		// Walk back from the end of the match with the reverse DFA, the last accepting spot is the start.
+		size_t match_end = scan_addr - start + 1;
+		size_t limit = min(match_end, max_len);
+		const byte* match_start = 0;
+		uint32_t rev_state = rev_start;
+		for (size_t back = 1; back <= limit; back++) {
+			rev_state = rev[rev_state + classes[start[match_end - back]]];
+			if (rev_state == rev_dead)
+				break;
+			if (rev_state >= rev_accept)
+				match_start = start + match_end - back;
+		}
+
+		if (match_start) {
+			if (match_len)
+				*match_len = start + match_end - match_start;
+			return match_start;
+		}
+	}
+
+	return 0;
+}
+
+// Positions that can follow any position in a 64-bit mask.
+static inline uint64_t followMask(const uint64_t* table, uint64_t active) {
+	uint64_t result = 0;
+	for (int chunk = 0; chunk < 8 && active; chunk++, active >>= 8)
+		result |= table[chunk * 256 + (active & 0xFF)];
+	return result;
+}
+
+const byte* Memory::Pattern::findBitParallel(const byte* start, const byte* end, size_t* match_len) const {
+	const uint64_t* fwd = follow_fwd.data();
+	const uint64_t* rev = follow_rev.data();
+	uint64_t active = 0;
+
+	for (const byte* scan_addr = start; scan_addr < end; scan_addr++) {
+		if (!active && prefilter_byte >= 0) {
+			scan_addr = static_cast<const byte*>(memchr(scan_addr, prefilter_byte, end - scan_addr));
+			if (!scan_addr)
+				return 0;
+		}
+
+		active = (followMask(fwd, active) | first_pos) & pos_bytes[classes[*scan_addr]];
+		if (!(active & last_pos))
+			continue;
+
+		size_t match_end = scan_addr - start + 1;
+		size_t limit = min(match_end, max_len);
+		const byte* match_start = 0;
+		uint64_t rev_active = active & last_pos;
+		for (size_t back = 1; back <= limit && rev_active; back++) {
+			if (back > 1)
+				rev_active = followMask(rev, rev_active) & pos_bytes[classes[start[match_end - back]]];
+			if (rev_active & first_pos)
+				match_start = start + match_end - back;
+		}
+
+		if (match_start) {
+			if (match_len)
+				*match_len = start + match_end - match_start;
+			return match_start;
+		}
+	}
+
+	return 0;
+}
+
+// Scan memory locally for a compiled pattern.
+// Works like Memory::Local::scan, see Memory::Pattern for the pattern syntax.
+// match_len optionally receives the length of the match, since gaps make it variable.
+void* Memory::Local::patternScan(byte* scan_addr, byte* end_addr, const Pattern& pattern, uint32_t mem_type, uint32_t mem_prot, size_t* match_len) {
+	MEMORY_BASIC_INFORMATION mbi;
+
+	while (VirtualQuery(scan_addr, &mbi, sizeof(mbi)) && scan_addr < end_addr) {
+		byte* region_end = static_cast<byte*>(mbi.BaseAddress) + mbi.RegionSize;
+		if (mbi.State & MEM_COMMIT && mbi.Type & mem_type && mbi.Protect & mem_prot) {
+			const byte* found = pattern.find(scan_addr, region_end, match_len);
+			if (found)
+				return found < end_addr ? const_cast<byte*>(found) : 0;
+		}
+		scan_addr = region_end;
+	}
+
+	return 0;
+}
+
+// Scan memory of a remote process for a compiled pattern.
+// Works like Memory::Remote::scan, see Memory::Pattern for the pattern syntax.
+// match_len optionally receives the length of the match, since gaps make it variable.
+void* Memory::Remote::patternScan(HANDLE rmt_handle, byte* rmt_scan_addr, byte* rmt_end_addr, const Pattern& pattern, uint32_t mem_type, uint32_t mem_prot, size_t* match_len) {
+	if (!pattern.valid())
+		return 0;
+
+	byte* result = 0;
+	walkRegions(rmt_handle, rmt_scan_addr, rmt_end_addr, mem_type, mem_prot, pattern.maxLength() - 1, [&](byte* local_buf, size_t len, byte* rmt_addr) {
+		const byte* found = pattern.find(local_buf, local_buf + len, match_len);
+		if (found)
+			result = rmt_addr + (found - local_buf);
+		return found != 0;
+	});
+
+	return result < rmt_end_addr ? result : 0;
+}
\ No newline at end of file
@@ -0,0 +1,112 @@
+#pragma once
+#include <stdint.h>
+#include <Windows.h>
+#include <vector>
+
+#include "win32memory.hpp"
+
+// Limits for compiled patterns.
+#define PATTERN_MAX_DFA_STATES  4096  // Past this the pattern falls back to the bit-parallel engine.
+#define PATTERN_MAX_POSITIONS   64    // Largest number of byte positions the bit-parallel engine handles.
+#define PATTERN_MAX_GAP         256   // Largest upper bound allowed on a [n-m] gap.
+
+// Builds the automata of a Memory::Pattern (win32pattern.cpp).
+struct PatternCompiler;
+
+namespace Memory {
+	// A byte pattern compiled into a DFA.
+	//
+	// Pattern syntax (whitespace separates elements, hex is case-insensitive):
+	//   8B          exact byte
+	//   ?? or ?     any byte
+	//   4? or ?5    nibble wildcard (high or low nibble fixed)
+	//   00-1F       inclusive byte range
+	//   74|75       byte set, any of the listed bytes/nibbles/ranges (no spaces around the |)
+	//   [4-16]      gap of 4 to 16 bytes of anything, [4] is exactly 4
+	//   (a | b c)   group, matches any of the |-separated sequences inside it
+	//
+	// e.g. "48 8B 05 ?? ?? ?? ?? 74|75 [1-8] (E8 | FF 15) ?? ?? ?? ??"
+	class Pattern {
+	public:
+		Pattern();
+
+		// Compile pattern source.
+		// Returns false if the source is malformed, matches the empty string, or is too big.
+		bool compile(const char* src);
+
+		// Whether the last compile() succeeded.
+		bool valid() const { return max_len != 0; }
+
+		// Shortest and longest number of bytes a match can span.
+		size_t minLength() const { return min_len; }
+		size_t maxLength() const { return max_len; }
+
+		// Whether matching runs on the minimized DFA (true) or the bit-parallel fallback (false).
+		bool usesDfa() const { return !fwd_next.empty(); }
+
+		// Find the first match within a local buffer.
+		// Returns the start of the match or 0, and optionally stores the length of the match in match_len.
+		const byte* find(const byte* start, const byte* end, size_t* match_len = 0) const;
+
+	private:
+		size_t min_len;
+		size_t max_len;
+
+		byte classes[256];      // Byte -> equivalence class.
+		uint32_t num_classes;
+		int prefilter_byte;     // Only byte that can start a match, or -1.
+
+		// Minimized DFAs, transitions are stored as row offsets (state * num_classes).
+		// Accepting states are numbered last so acceptance is a single compare against *_accept.
+		std::vector<uint32_t> fwd_next;  // Unanchored forward DFA, accepts where a match ends.
+		uint32_t fwd_start;
+		uint32_t fwd_accept;
+		std::vector<uint32_t> rev_next;  // Anchored reverse DFA, run backwards from a match end to find its start.
+		uint32_t rev_start;
+		uint32_t rev_accept;
+		uint32_t rev_dead;
+
+		// Bit-parallel fallback, used when the DFA would get too big.
+		// Active positions are a bitmask, follow sets are looked up one byte of the mask at a time.
+		std::vector<uint64_t> pos_bytes;    // Per class, positions whose byte set contains the class.
+		std::vector<uint64_t> follow_fwd;   // [8][256] follow tables.
+		std::vector<uint64_t> follow_rev;   // [8][256] reverse follow tables.
+		uint64_t first_pos;
+		uint64_t last_pos;
+
+		friend struct ::PatternCompiler;
+
+		const byte* findDfa(const byte* start, const byte* end, size_t* match_len) const;
+		const byte* findBitParallel(const byte* start, const byte* end, size_t* match_len) const;
+	};
+
+	namespace Local {
+		// Scan memory locally for a compiled pattern.
+		void* patternScan(byte* start_addr, byte* end_addr, const Pattern& pattern, uint32_t mem_type, uint32_t mem_prot, size_t* match_len = 0);
+
+		// Scan memory locally for a compiled pattern.
+		inline void* patternScan(void* start_addr, void* end_addr, const Pattern& pattern, uint32_t mem_type, uint32_t mem_prot, size_t* match_len = 0) {
+			return patternScan(static_cast<byte*>(start_addr), static_cast<byte*>(end_addr), pattern, mem_type, mem_prot, match_len);
+		}
+
+		// Scan memory locally for a compiled pattern.
+		inline void* patternScan(uint32_t start_addr, uint32_t end_addr, const Pattern& pattern, uint32_t mem_type, uint32_t mem_prot, size_t* match_len = 0) {
+			return patternScan(reinterpret_cast<byte*>(start_addr), reinterpret_cast<byte*>(end_addr), pattern, mem_type, mem_prot, match_len);
+		}
+	}
+
+	namespace Remote {
+		// Scan memory of a remote process for a compiled pattern.
+		void* patternScan(HANDLE rmt_handle, byte* rmt_start_addr, byte* rmt_end_addr, const Pattern& pattern, uint32_t mem_type, uint32_t mem_prot, size_t* match_len = 0);
+
+		// Scan memory of a remote process for a compiled pattern.
+		inline void* patternScan(HANDLE rmt_handle, void* rmt_start_addr, void* rmt_end_addr, const Pattern& pattern, uint32_t mem_type, uint32_t mem_prot, size_t* match_len = 0) {
+			return patternScan(rmt_handle, static_cast<byte*>(rmt_start_addr), static_cast<byte*>(rmt_end_addr), pattern, mem_type, mem_prot, match_len);
+		}
+
+		// Scan memory of a remote process for a compiled pattern.
+		inline void* patternScan(HANDLE rmt_handle, uint32_t rmt_start_addr, uint32_t rmt_end_addr, const Pattern& pattern, uint32_t mem_type, uint32_t mem_prot, size_t* match_len = 0) {
+			return patternScan(rmt_handle, reinterpret_cast<byte*>(rmt_start_addr), reinterpret_cast<byte*>(rmt_end_addr), pattern, mem_type, mem_prot, match_len);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,210 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+#include "win32backend.hpp"
+
+namespace Memory {
+	template <typename T> class RemoteRef;
+
+	// Offset of a member within T, for remote pointers to members.
+	template <typename T, typename M>
+	inline uint32_t memberOffset(M T::* field) {
+		return reinterpret_cast<uint32_t>(&(reinterpret_cast<const T*>(0)->*field));
+	}
+
+	// Typed pointer into the memory of a remote process, read and written through a RemoteBackend.
+	// Behaves like a T* for arithmetic and comparison. Dereferencing gives a RemoteRef<T> holding a local
+	// copy of the value, so e.g. ptr->health reads the whole T once and then reads the copy.
+	// Nothing is allocated on the heap, the backend isn't owned.
+	template <typename T>
+	class RemotePtr {
+	public:
+		RemotePtr() : backend(0), addr(0) {}
+		RemotePtr(RemoteBackend* backend, uint32_t rmt_addr) : backend(backend), addr(rmt_addr) {}
+		RemotePtr(RemoteBackend* backend, const void* rmt_addr) : backend(backend), addr(reinterpret_cast<uint32_t>(rmt_addr)) {}
+
+		uint32_t address() const { return addr; }
+		RemoteBackend* source() const { return backend; }
+		explicit operator bool() const { return addr != 0; }
+
+		// Reference to the value pointed to, fetched on first access.
+		RemoteRef<T> operator*() const { return RemoteRef<T>(backend, addr); }
+		RemoteRef<T> operator[](ptrdiff_t idx) const { return RemoteRef<T>(backend, addr + static_cast<uint32_t>(idx * sizeof(T))); }
+
+		// The returned reference lives until the end of the expression, its operator-> gives the local copy.
+		RemoteRef<T> operator->() const { return RemoteRef<T>(backend, addr); }
+
+		// Read the value directly, without keeping a copy. T() if it can't be read.
+		T get() const {
+			T value;
+			if (!backend || !backend->read(addr, &value, sizeof(T)))
+				return T();
+			return value;
+		}
+
+		// Write the value directly.
+		bool set(const T& value) const {
+			return backend && backend->write(addr, &value, sizeof(T));
+		}
+
+		// Pointer to a member of the T pointed to. Array members give a pointer to their first element.
+		template <typename M, typename C>
+		RemotePtr<typename std::remove_extent<M>::type> member(M C::* field) const {
+			static_assert(std::is_same<C, T>::value, "member() needs a member of T");
+			return RemotePtr<typename std::remove_extent<M>::type>(backend, addr + memberOffset(field));
+		}
+
+		// Pointer to something of type U at a byte offset from this pointer.
+		template <typename U>
+		RemotePtr<U> at(uint32_t offset) const { return RemotePtr<U>(backend, addr + offset); }
+
+		// Follow the (32 bit) pointer stored at this address, e.g. RemotePtr<Player*>::deref() gives a RemotePtr<Player>.
+		// Null if it can't be read.
+		template <typename U = typename std::remove_pointer<T>::type>
+		RemotePtr<U> deref() const {
+			uint32_t target = 0;
+			if (!backend || !backend->read(addr, &target, sizeof(target)))
+				return RemotePtr<U>(backend, static_cast<uint32_t>(0));
+			return RemotePtr<U>(backend, target);
+		}
+
+		RemotePtr operator+(ptrdiff_t n) const { return RemotePtr(backend, addr + static_cast<uint32_t>(n * sizeof(T))); }
+		RemotePtr operator-(ptrdiff_t n) const { return RemotePtr(backend, addr - static_cast<uint32_t>(n * sizeof(T))); }
+		ptrdiff_t operator-(const RemotePtr& other) const { return static_cast<ptrdiff_t>(static_cast<int32_t>(addr - other.addr)) / static_cast<ptrdiff_t>(sizeof(T)); }
+		RemotePtr& operator+=(ptrdiff_t n) { addr += static_cast<uint32_t>(n * sizeof(T)); return *this; }
+		RemotePtr& operator-=(ptrdiff_t n) { addr -= static_cast<uint32_t>(n * sizeof(T)); return *this; }
+		RemotePtr& operator++() { addr += sizeof(T); return *this; }
+		RemotePtr& operator--() { addr -= sizeof(T); return *this; }
+		RemotePtr operator++(int) { RemotePtr old = *this; addr += sizeof(T); return old; }
+		RemotePtr operator--(int) { RemotePtr old = *this; addr -= sizeof(T); return old; }
+
+		bool operator==(const RemotePtr& other) const { return addr == other.addr; }
+		bool operator!=(const RemotePtr& other) const { return addr != other.addr; }
+		bool operator<(const RemotePtr& other) const { return addr < other.addr; }
+		bool operator<=(const RemotePtr& other) const { return addr <= other.addr; }
+		bool operator>(const RemotePtr& other) const { return addr > other.addr; }
+		bool operator>=(const RemotePtr& other) const { return addr >= other.addr; }
+
+	private:
+		RemoteBackend* backend;
+		uint32_t addr;
+	};
+
+	// Local copy of a T in a remote process.
+	// The value is fetched on first access and changes stay local until commit(), which only writes back
+	// the bytes that were changed. Nothing is written when the reference goes away, call commit().
+	// Since a temporary would lose its changes, only named references can be changed: *ptr = v and
+	// ptr[i] = v don't compile (use RemotePtr::set, or keep the reference and commit it), and neither does
+	// assigning one reference to another. T should be trivially copyable.
+	template <typename T>
+	class RemoteRef {
+	public:
+		RemoteRef(RemoteBackend* backend, uint32_t rmt_addr) : backend(backend), addr(rmt_addr), fetched(false), fetch_ok(false),
+			dirty_lo(sizeof(T)), dirty_hi(0) {}
+
+		RemoteRef(const RemoteRef&) = default;
+		RemoteRef& operator=(const RemoteRef&) = delete;
+
+		uint32_t address() const { return addr; }
+		RemotePtr<T> operator&() const { return RemotePtr<T>(backend, addr); }
+
+		// Fetch the value if that hasn't been done yet. Returns whether it could be read.
+		// If it couldn't, the local copy is zeroed.
+		bool fetch() const {
+			if (!fetched) {
+				fetched = true;
+				fetch_ok = backend && backend->read(addr, &value, sizeof(T));
+				if (!fetch_ok)
+					memset(&value, 0, sizeof(T));
+			}
+			return fetch_ok;
+		}
+
+		// Whether the value could be read.
+		bool ok() const { return fetch(); }
+
+		// Local copy of the value.
+		const T& get() const { fetch(); return value; }
+		operator const T&() const { return get(); }
+		const T* operator->() const { return &get(); }
+
+		// Mutable access to the local copy. Marks all of it as changed.
+		T* mut() & {
+			fetch();
+			markDirty(0, sizeof(T));
+			return &value;
+		}
+		T* mut() && = delete;
+
+		// Replace the whole value.
+		RemoteRef& operator=(const T& new_value) & {
+			fetched = true;
+			fetch_ok = true;
+			value = new_value;
+			markDirty(0, sizeof(T));
+			return *this;
+		}
+		RemoteRef& operator=(const T& new_value) && = delete;
+
+		// Change one member, only its bytes get written back.
+		template <typename M, typename C>
+		void set(M C::* field, const M& field_value) & {
+			static_assert(std::is_same<C, T>::value, "set() needs a member of T");
+			fetch();
+			uint32_t offset = memberOffset(field);
+			memcpy(reinterpret_cast<byte*>(&value) + offset, &field_value, sizeof(M));
+			markDirty(offset, offset + sizeof(M));
+		}
+		template <typename M, typename C>
+		void set(M C::* field, const M& field_value) && = delete;
+
+		// Whether there are changes that haven't been written back.
+		bool dirty() const { return dirty_lo < dirty_hi; }
+
+		// Write back the changed bytes, as one write. Returns true if there was nothing to write.
+		bool commit() {
+			if (!dirty())
+				return true;
+			if (!backend || !backend->write(addr + static_cast<uint32_t>(dirty_lo), reinterpret_cast<const byte*>(&value) + dirty_lo, dirty_hi - dirty_lo))
+				return false;
+			dirty_lo = sizeof(T);
+			dirty_hi = 0;
+			return true;
+		}
+
+		// Throw away the local copy and any changes, the next access fetches again.
+		void refresh() {
+			fetched = false;
+			dirty_lo = sizeof(T);
+			dirty_hi = 0;
+		}
+
+		// Follow the (32 bit) pointer held in the local copy.
+		template <typename U = typename std::remove_pointer<T>::type>
+		RemotePtr<U> deref() const {
+			static_assert(sizeof(T) >= sizeof(uint32_t), "deref() needs a pointer value");
+			uint32_t target;
+			memcpy(&target, &get(), sizeof(target));
+			return RemotePtr<U>(backend, target);
+		}
+
+	private:
+		RemoteBackend* backend;
+		uint32_t addr;
+		mutable T value;
+		mutable bool fetched;
+		mutable bool fetch_ok;
+		size_t dirty_lo;  // Changed bytes of the local copy, [dirty_lo, dirty_hi).
+		size_t dirty_hi;
+
+		void markDirty(size_t lo, size_t hi) {
+			if (lo < dirty_lo)
+				dirty_lo = lo;
+			if (hi > dirty_hi)
+				dirty_hi = hi;
+		}
+	};
+}
\ No newline at end of file
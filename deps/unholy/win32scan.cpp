@@ -0,0 +1,939 @@
+#include "win32scan.hpp"
+
+#include <algorithm>
+#include <emmintrin.h>
+#include <intrin.h>
+
+// Load the same 64-bit value into both lanes of an sse register.
+// (_mm_set1_epi64x is not available on every x86 toolchain)
+static inline __m128i broadcast64(uint64_t val) {
+	uint64_t pair[2] = { val, val };
+	return _mm_loadu_si128(reinterpret_cast<const __m128i*>(pair));
+}
+
+// ------------------------
+// FUZZY SCANNING
+// ------------------------
+
+// The fuzzy scanner is a shift-add matcher (Baeza-Yates & Gonnet), the k-mismatch sibling of shift-or.
+// Every byte of the pattern gets a small counter packed into a 64-bit state word. Counter j holds the
+// number of mismatched fixed bytes between pattern[0..j] and the text ending at the current byte.
+// Each text byte shifts every counter up one field and adds a precomputed "does pattern[j] differ from
+// this byte" bit to each of them, so a whole step is one shift, one add and a table lookup.
+//
+// Counters are field_bits wide, with the top bit of each field used to catch counters that went past
+// max_mismatches. Those bits get moved into a sticky overflow word that shifts along with the state.
+//
+// Only the first filter_len bytes of the pattern fit in a single state word. Candidates that pass the
+// filter get verified over the whole pattern, which also produces the exact mismatch count.
+//
+// Two independent halves of the buffer run in the two 64-bit lanes of an sse register, which is where
+// most of the speedup over a scalar loop comes from on x86 (no 64-bit general purpose registers).
+
+// Precomputed state for the shift-add matcher.
+struct FuzzyPattern {
+	const char* data;
+	const char* mask;
+	size_t len;
+	uint32_t max_mismatches;
+
+	uint32_t count_bits;    // Bits per counter, not including its overflow bit.
+	uint32_t field_bits;    // Bits per counter including its overflow bit.
+	size_t filter_len;      // Number of pattern bytes tracked by the state word.
+
+	uint64_t table[256];    // Per text byte, a 1 in every field whose pattern byte is fixed and differs.
+	uint64_t high_bits;     // Overflow bit of every field.
+	uint64_t all_bits;      // Every bit belonging to a field.
+	uint64_t threshold;     // Added to the last counter so that it carries into test_bit when it is > max_mismatches.
+	uint64_t test_bit;      // Overflow bit of the last counter.
+};
+
+// Fill out a FuzzyPattern from data/mask.
+// Returns false if the pattern is empty or max_mismatches is too large.
+static bool buildFuzzyPattern(FuzzyPattern& pattern, const char* data, const char* mask, uint32_t max_mismatches) {
+	pattern.data = data;
+	pattern.mask = mask;
+	pattern.len = strlen(mask);
+	pattern.max_mismatches = max_mismatches;
+	if (!pattern.len || max_mismatches > FUZZY_MAX_MISMATCHES)
+		return false;
+
+	pattern.count_bits = 1;
+	while ((1u << pattern.count_bits) <= max_mismatches)
+		pattern.count_bits++;
+	pattern.field_bits = pattern.count_bits + 1;
+	pattern.filter_len = min(pattern.len, static_cast<size_t>(64 / pattern.field_bits));
+
+	size_t used_bits = pattern.filter_len * pattern.field_bits;
+	pattern.all_bits = used_bits < 64 ? (1ULL << used_bits) - 1 : ~0ULL;
+	pattern.high_bits = 0;
+	memset(pattern.table, 0, sizeof(pattern.table));
+
+	for (size_t j = 0; j < pattern.filter_len; j++) {
+		pattern.high_bits |= 1ULL << (j * pattern.field_bits + pattern.count_bits);
+		if (mask[j] != 'x')
+			continue;
+
+		for (uint32_t c = 0; c < 256; c++)
+			if (static_cast<byte>(data[j]) != c)
+				pattern.table[c] |= 1ULL << (j * pattern.field_bits);
+	}
+
+	size_t last_field = (pattern.filter_len - 1) * pattern.field_bits;
+	pattern.threshold = static_cast<uint64_t>((1u << pattern.count_bits) - 1 - max_mismatches) << last_field;
+	pattern.test_bit = 1ULL << (last_field + pattern.count_bits);
+
+	return true;
+}
+
+// Count mismatched fixed bytes of the whole pattern against the text at scan_addr.
+// Gives up as soon as the count goes past limit.
+static inline uint32_t countMismatches(const byte* scan_addr, const FuzzyPattern& pattern, uint32_t limit) {
+	uint32_t mismatches = 0;
+	for (size_t j = 0; j < pattern.len; j++)
+		if (pattern.mask[j] == 'x' && static_cast<byte>(pattern.data[j]) != scan_addr[j] && ++mismatches > limit)
+			break;
+	return mismatches;
+}
+
+// Verify a candidate that passed the shift-add filter and record it if it really matches.
+static inline void checkFuzzyCandidate(const byte* buf, size_t len, size_t start, const FuzzyPattern& pattern, byte* report_base, std::vector<Memory::FuzzyHit>& hits) {
+	if (start + pattern.len > len)
+		return;
+
+	uint32_t mismatches = countMismatches(buf + start, pattern, pattern.max_mismatches);
+	if (mismatches <= pattern.max_mismatches)
+		hits.push_back({ report_base + start, mismatches });
+}
+
+// Run the fuzzy matcher over a local buffer.
+// Hits are reported relative to report_base, so remote scans can pass the remote address of the buffer.
+// Only matches that fit entirely inside the buffer are reported.
+static void fuzzyScanBuffer(const byte* buf, size_t len, const FuzzyPattern& pattern, byte* report_base, std::vector<Memory::FuzzyHit>& hits) {
+	if (len < pattern.len)
+		return;
+
+	// Lane A runs over buf[0, steps), lane B over buf[lane_b, len).
+	// Both need filter_len - 1 bytes of warm up, so the lanes overlap by that much and lane A only
+	// reports match ends before the point lane B starts reporting.
+	size_t warmup = pattern.filter_len - 1;
+	size_t steps = (len + warmup + 1) / 2;
+	size_t lane_b = len - steps;
+
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i shift = _mm_cvtsi32_si128(pattern.field_bits);
+	const __m128i high = broadcast64(pattern.high_bits);
+	const __m128i all = broadcast64(pattern.all_bits);
+	const __m128i threshold = broadcast64(pattern.threshold);
+	const __m128i test = broadcast64(pattern.test_bit);
+
+	// Lane B's hits are held back so the results come out in address order.
+	std::vector<Memory::FuzzyHit> lane_b_hits;
+	__m128i state = zero;
+	__m128i overflow = zero;
+	for (size_t i = 0; i < steps; i++) {
+		__m128i bits = _mm_unpacklo_epi64(
+			_mm_loadl_epi64(reinterpret_cast<const __m128i*>(&pattern.table[buf[i]])),
+			_mm_loadl_epi64(reinterpret_cast<const __m128i*>(&pattern.table[buf[lane_b + i]])));
+
+		state = _mm_add_epi64(_mm_and_si128(_mm_sll_epi64(state, shift), all), bits);
+		overflow = _mm_and_si128(_mm_or_si128(_mm_sll_epi64(overflow, shift), _mm_and_si128(state, high)), all);
+		state = _mm_andnot_si128(high, state);
+
+		// A lane is a candidate when its last counter is within budget and never overflowed.
+		__m128i miss = _mm_and_si128(_mm_or_si128(_mm_add_epi64(state, threshold), overflow), test);
+		int candidates = _mm_movemask_epi8(_mm_cmpeq_epi32(miss, zero));
+		if (i >= warmup) {
+			if ((candidates & 0xFF) == 0xFF && i < lane_b + warmup)
+				checkFuzzyCandidate(buf, len, i - warmup, pattern, report_base, hits);
+			if ((candidates & 0xFF00) == 0xFF00)
+				checkFuzzyCandidate(buf, len, lane_b + i - warmup, pattern, report_base, lane_b_hits);
+		}
+	}
+
+	hits.insert(hits.end(), lane_b_hits.begin(), lane_b_hits.end());
+}
+
+// Scan memory locally for a pattern, tolerating up to max_mismatches differing fixed bytes.
+// Arguments are the same as Memory::Local::scan, plus max_mismatches which is the number of fixed ("x")
+// bytes of the pattern that are allowed to differ. It can be at most FUZZY_MAX_MISMATCHES.
+// Returns every position the pattern starts at along with how many fixed bytes differed there.
+std::vector<Memory::FuzzyHit> Memory::Local::fuzzyScan(byte* scan_addr, byte* end_addr, const char* data, const char* mask, uint32_t max_mismatches, uint32_t mem_type, uint32_t mem_prot) {
+	std::vector<FuzzyHit> hits;
+	FuzzyPattern pattern;
+	if (!buildFuzzyPattern(pattern, data, mask, max_mismatches))
+		return hits;
+
+	MEMORY_BASIC_INFORMATION mbi;
+	while (VirtualQuery(scan_addr, &mbi, sizeof(mbi)) && scan_addr < end_addr) {
+		byte* region_end = static_cast<byte*>(mbi.BaseAddress) + mbi.RegionSize;
+		if (mbi.State & MEM_COMMIT && mbi.Type & mem_type && mbi.Protect & mem_prot)
+			fuzzyScanBuffer(scan_addr, region_end - scan_addr, pattern, scan_addr, hits);
+		scan_addr = region_end;
+	}
+
+	while (!hits.empty() && hits.back().addr >= end_addr)
+		hits.pop_back();
+	return hits;
+}
+
+// Scan memory of a remote process for a pattern, tolerating up to max_mismatches differing fixed bytes.
+// Arguments are the same as Memory::Remote::scan, plus max_mismatches which is the number of fixed ("x")
+// bytes of the pattern that are allowed to differ. It can be at most FUZZY_MAX_MISMATCHES.
+// Returns every (remote) position the pattern starts at along with how many fixed bytes differed there.
+std::vector<Memory::FuzzyHit> Memory::Remote::fuzzyScan(HANDLE rmt_handle, byte* rmt_scan_addr, byte* rmt_end_addr, const char* data, const char* mask, uint32_t max_mismatches, uint32_t mem_type, uint32_t mem_prot) {
+	std::vector<FuzzyHit> hits;
+	FuzzyPattern pattern;
+	if (!buildFuzzyPattern(pattern, data, mask, max_mismatches))
+		return hits;
+
+	walkRegions(rmt_handle, rmt_scan_addr, rmt_end_addr, mem_type, mem_prot, pattern.len - 1, [&](byte* local_buf, size_t len, byte* rmt_addr) {
+		fuzzyScanBuffer(local_buf, len, pattern, rmt_addr, hits);
+		return false;
+	});
+
+	while (!hits.empty() && hits.back().addr >= rmt_end_addr)
+		hits.pop_back();
+	return hits;
+}
+// ------------------------
+// VALUE SCANNING
+// ------------------------
+
+// Values are compared four dwords (one sse register) at a time, only at offsets aligned to the value size.
+// 8 byte values compare as dword pairs, a lane pair only matches if both of its halves do.
+// Sets first reject values outside of [min, max] with a vector compare (which is most of memory when
+// hunting for pointers into one heap or module), then look the rest up in the perfect hash.
+
+// Small deterministic xorshift generator for picking hash multipliers.
+static inline uint32_t nextRandom(uint32_t& state) {
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+Memory::ValueSet::ValueSet(size_t value_size) : value_size(value_size == 8 ? 8 : 4), mix_mul(0), bucket_mul(0), bucket_shift(32),
+	slot_mul(0), slot_shift(31), slot_mask(0), min_value(0), max_value(0) {}
+
+void Memory::ValueSet::add(uint64_t value) {
+	values.push_back(value_size == 4 ? static_cast<uint32_t>(value) : value);
+}
+
+// Tries random multipliers with a table of at least one slot per value, doubling the table every few
+// failed attempts. Buckets average two values and get placed biggest first, each one taking the
+// smallest displacement that moves all of its values into free slots.
+bool Memory::ValueSet::build() {
+	std::sort(values.begin(), values.end());
+	values.erase(std::unique(values.begin(), values.end()), values.end());
+	if (values.empty())
+		return false;
+
+	min_value = values.front();
+	max_value = values.back();
+
+	uint32_t slot_bits = 1;
+	while ((1ULL << slot_bits) < values.size())
+		slot_bits++;
+
+	uint32_t seed = 0x9E3779B9;
+	std::vector<uint32_t> mixed(values.size());
+	std::vector<uint32_t> order(values.size());
+	std::vector<byte> used;
+	for (uint32_t attempt = 0;; attempt++) {
+		if (attempt && attempt % 8 == 0)
+			slot_bits++;
+
+		uint32_t bucket_bits = slot_bits - 1;
+		uint32_t slots = 1u << slot_bits;
+		mix_mul = (static_cast<uint64_t>(nextRandom(seed)) << 32 | nextRandom(seed)) | 1;
+		bucket_mul = nextRandom(seed) | 1;
+		slot_mul = nextRandom(seed) | 1;
+		bucket_shift = 32 - bucket_bits;
+		slot_shift = 32 - slot_bits;
+		slot_mask = slots - 1;
+
+		// Group values by bucket, biggest buckets first.
+		std::vector<uint32_t> bucket_of(values.size());
+		std::vector<uint32_t> bucket_size(1u << bucket_bits, 0);
+		for (size_t i = 0; i < values.size(); i++) {
+			mixed[i] = value_size == 4 ? static_cast<uint32_t>(values[i]) : static_cast<uint32_t>((values[i] * mix_mul) >> 32);
+			bucket_of[i] = static_cast<uint32_t>(static_cast<uint64_t>(mixed[i] * bucket_mul) >> bucket_shift);
+			bucket_size[bucket_of[i]]++;
+			order[i] = static_cast<uint32_t>(i);
+		}
+		std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+			if (bucket_size[bucket_of[a]] != bucket_size[bucket_of[b]])
+				return bucket_size[bucket_of[a]] > bucket_size[bucket_of[b]];
+			return bucket_of[a] < bucket_of[b];
+		});
+
+		disp.assign(1u << bucket_bits, 0);
+		table.assign(slots, values.front());
+		used.assign(slots, 0);
+		bool placed = true;
+		for (size_t first = 0; placed && first < order.size();) {
+			size_t last = first;
+			while (last < order.size() && bucket_of[order[last]] == bucket_of[order[first]])
+				last++;
+
+			placed = false;
+			for (uint32_t d = 0; d < slots && !placed; d++) {
+				size_t j = first;
+				for (; j < last; j++) {
+					uint32_t slot = ((mixed[order[j]] * slot_mul) >> slot_shift) + d & slot_mask;
+					if (used[slot])
+						break;
+					used[slot] = 1;
+				}
+
+				if (j == last) {
+					placed = true;
+					disp[bucket_of[order[first]]] = d;
+					for (j = first; j < last; j++)
+						table[((mixed[order[j]] * slot_mul) >> slot_shift) + d & slot_mask] = values[order[j]];
+				} else {
+					// Undo the slots this displacement claimed before the collision.
+					for (size_t k = first; k < j; k++)
+						used[((mixed[order[k]] * slot_mul) >> slot_shift) + d & slot_mask] = 0;
+				}
+			}
+			first = last;
+		}
+
+		if (placed)
+			return true;
+	}
+}
+
+// First offset into a buffer at which the reported address is aligned to align bytes.
+static inline size_t alignedStart(byte* report_base, size_t align) {
+	return (align - reinterpret_cast<uintptr_t>(report_base) % align) % align;
+}
+
+// Record every set bit of a lane mask as a hit.
+// lanes is the number of values per mask (4 dwords or 2 qwords per register).
+static inline void pushLaneHits(int mask, size_t lanes, size_t lane_size, byte* report_base, size_t offset, std::vector<void*>& hits) {
+	for (size_t k = 0; k < lanes; k++)
+		if (mask & (1 << k))
+			hits.push_back(report_base + offset + k * lane_size);
+}
+
+// Find every aligned 4 byte value within a local buffer.
+static void valueScanBuffer(const byte* buf, size_t len, uint32_t value, byte* report_base, std::vector<void*>& hits) {
+	size_t i = alignedStart(report_base, 4);
+	const __m128i target = _mm_set1_epi32(static_cast<int>(value));
+
+	// 64 bytes per iteration with a single branch, almost every block has no hit.
+	for (; i + 64 <= len; i += 64) {
+		__m128i c0 = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + i)), target);
+		__m128i c1 = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + i + 16)), target);
+		__m128i c2 = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + i + 32)), target);
+		__m128i c3 = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + i + 48)), target);
+		if (!_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(c0, c1), _mm_or_si128(c2, c3))))
+			continue;
+
+		pushLaneHits(_mm_movemask_ps(_mm_castsi128_ps(c0)), 4, 4, report_base, i, hits);
+		pushLaneHits(_mm_movemask_ps(_mm_castsi128_ps(c1)), 4, 4, report_base, i + 16, hits);
+		pushLaneHits(_mm_movemask_ps(_mm_castsi128_ps(c2)), 4, 4, report_base, i + 32, hits);
+		pushLaneHits(_mm_movemask_ps(_mm_castsi128_ps(c3)), 4, 4, report_base, i + 48, hits);
+	}
+
+	for (; i + 4 <= len; i += 4)
+		if (*reinterpret_cast<const uint32_t*>(buf + i) == value)
+			hits.push_back(report_base + i);
+}
+
+// Find every aligned 8 byte value within a local buffer.
+static void valueScan64Buffer(const byte* buf, size_t len, uint64_t value, byte* report_base, std::vector<void*>& hits) {
+	size_t i = alignedStart(report_base, 8);
+	const __m128i target = broadcast64(value);
+
+	for (; i + 32 <= len; i += 32) {
+		__m128i c0 = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + i)), target);
+		__m128i c1 = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + i + 16)), target);
+		c0 = _mm_and_si128(c0, _mm_shuffle_epi32(c0, _MM_SHUFFLE(2, 3, 0, 1)));
+		c1 = _mm_and_si128(c1, _mm_shuffle_epi32(c1, _MM_SHUFFLE(2, 3, 0, 1)));
+		if (!_mm_movemask_epi8(_mm_or_si128(c0, c1)))
+			continue;
+
+		pushLaneHits(_mm_movemask_pd(_mm_castsi128_pd(c0)), 2, 8, report_base, i, hits);
+		pushLaneHits(_mm_movemask_pd(_mm_castsi128_pd(c1)), 2, 8, report_base, i + 16, hits);
+	}
+
+	for (; i + 8 <= len; i += 8)
+		if (*reinterpret_cast<const uint64_t*>(buf + i) == value)
+			hits.push_back(report_base + i);
+}
+
+// Find every aligned value of a set within a local buffer.
+static void valueSetScanBuffer(const byte* buf, size_t len, const Memory::ValueSet& set, byte* report_base, std::vector<void*>& hits) {
+	size_t i = alignedStart(report_base, set.valueSize());
+	if (set.valueSize() == 8) {
+		for (; i + 8 <= len; i += 8) {
+			uint64_t val = *reinterpret_cast<const uint64_t*>(buf + i);
+			if (val >= set.minValue() && val <= set.maxValue() && set.contains(val))
+				hits.push_back(report_base + i);
+		}
+		return;
+	}
+
+	// sse2 only has signed compares, flipping the sign bit makes them order like unsigned.
+	const __m128i bias = _mm_set1_epi32(static_cast<int>(0x80000000));
+	const __m128i lo = _mm_xor_si128(_mm_set1_epi32(static_cast<int>(set.minValue())), bias);
+	const __m128i hi = _mm_xor_si128(_mm_set1_epi32(static_cast<int>(set.maxValue())), bias);
+	for (; i + 16 <= len; i += 16) {
+		__m128i vals = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + i)), bias);
+		__m128i outside = _mm_or_si128(_mm_cmpgt_epi32(lo, vals), _mm_cmpgt_epi32(vals, hi));
+		int in_range = ~_mm_movemask_ps(_mm_castsi128_ps(outside)) & 0xF;
+		for (; in_range; in_range &= in_range - 1) {
+			size_t k = in_range & 1 ? 0 : in_range & 2 ? 1 : in_range & 4 ? 2 : 3;
+			if (set.contains(*reinterpret_cast<const uint32_t*>(buf + i + k * 4)))
+				hits.push_back(report_base + i + k * 4);
+		}
+	}
+
+	for (; i + 4 <= len; i += 4)
+		if (set.contains(*reinterpret_cast<const uint32_t*>(buf + i)))
+			hits.push_back(report_base + i);
+}
+
+// Walk local regions and run a buffer scanner over each readable part of [scan_addr, end_addr).
+template <typename F>
+static void scanLocalRegions(byte* scan_addr, byte* end_addr, uint32_t mem_type, uint32_t mem_prot, F scan_buffer) {
+	MEMORY_BASIC_INFORMATION mbi;
+	while (VirtualQuery(scan_addr, &mbi, sizeof(mbi)) && scan_addr < end_addr) {
+		byte* region_end = static_cast<byte*>(mbi.BaseAddress) + mbi.RegionSize;
+		if (mbi.State & MEM_COMMIT && mbi.Type & mem_type && mbi.Protect & mem_prot)
+			scan_buffer(scan_addr, min(region_end, end_addr) - scan_addr, scan_addr);
+		scan_addr = region_end;
+	}
+}
+
+// Walk remote regions and run a buffer scanner over each readable part of [rmt_scan_addr, rmt_end_addr).
+// Chunks overlap by item_size - 1 bytes so items straddling a chunk boundary are seen whole.
+template <typename F>
+static void scanRemoteRegions(HANDLE rmt_handle, byte* rmt_scan_addr, byte* rmt_end_addr, size_t item_size, uint32_t mem_type, uint32_t mem_prot, F scan_buffer) {
+	Memory::Remote::walkRegions(rmt_handle, rmt_scan_addr, rmt_end_addr, mem_type, mem_prot, item_size - 1, [&](byte* local_buf, size_t len, byte* rmt_addr) {
+		if (rmt_addr + len > rmt_end_addr)
+			len = rmt_end_addr > rmt_addr ? rmt_end_addr - rmt_addr : 0;
+		scan_buffer(local_buf, len, rmt_addr);
+		return false;
+	});
+}
+
+// Scan memory locally for every 4-byte aligned occurrence of a 4 byte value (e.g. a pointer).
+// Arguments are the same as Memory::Local::scan, with the value in place of data/mask.
+// Returns the address of every occurrence, in address order.
+std::vector<void*> Memory::Local::valueScan(byte* scan_addr, byte* end_addr, uint32_t value, uint32_t mem_type, uint32_t mem_prot) {
+	std::vector<void*> hits;
+	scanLocalRegions(scan_addr, end_addr, mem_type, mem_prot, [&](const byte* buf, size_t len, byte* report_base) {
+		valueScanBuffer(buf, len, value, report_base, hits);
+	});
+	return hits;
+}
+
+// Scan memory locally for every 8-byte aligned occurrence of an 8 byte value.
+// Returns the address of every occurrence, in address order.
+std::vector<void*> Memory::Local::valueScan64(byte* scan_addr, byte* end_addr, uint64_t value, uint32_t mem_type, uint32_t mem_prot) {
+	std::vector<void*> hits;
+	scanLocalRegions(scan_addr, end_addr, mem_type, mem_prot, [&](const byte* buf, size_t len, byte* report_base) {
+		valueScan64Buffer(buf, len, value, report_base, hits);
+	});
+	return hits;
+}
+
+// Scan memory locally for every occurrence of any value of a (built) set, aligned to the set's value size.
+// Returns the address of every occurrence, in address order.
+std::vector<void*> Memory::Local::valueSetScan(byte* scan_addr, byte* end_addr, const ValueSet& set, uint32_t mem_type, uint32_t mem_prot) {
+	std::vector<void*> hits;
+	if (!set.size())
+		return hits;
+
+	scanLocalRegions(scan_addr, end_addr, mem_type, mem_prot, [&](const byte* buf, size_t len, byte* report_base) {
+		valueSetScanBuffer(buf, len, set, report_base, hits);
+	});
+	return hits;
+}
+
+// Scan memory of a remote process for every 4-byte aligned occurrence of a 4 byte value (e.g. a pointer).
+// Arguments are the same as Memory::Remote::scan, with the value in place of data/mask.
+// Returns the (remote) address of every occurrence, in address order.
+std::vector<void*> Memory::Remote::valueScan(HANDLE rmt_handle, byte* rmt_scan_addr, byte* rmt_end_addr, uint32_t value, uint32_t mem_type, uint32_t mem_prot) {
+	std::vector<void*> hits;
+	scanRemoteRegions(rmt_handle, rmt_scan_addr, rmt_end_addr, 4, mem_type, mem_prot, [&](const byte* buf, size_t len, byte* report_base) {
+		valueScanBuffer(buf, len, value, report_base, hits);
+	});
+	return hits;
+}
+
+// Scan memory of a remote process for every 8-byte aligned occurrence of an 8 byte value.
+// Returns the (remote) address of every occurrence, in address order.
+std::vector<void*> Memory::Remote::valueScan64(HANDLE rmt_handle, byte* rmt_scan_addr, byte* rmt_end_addr, uint64_t value, uint32_t mem_type, uint32_t mem_prot) {
+	std::vector<void*> hits;
+	scanRemoteRegions(rmt_handle, rmt_scan_addr, rmt_end_addr, 8, mem_type, mem_prot, [&](const byte* buf, size_t len, byte* report_base) {
+		valueScan64Buffer(buf, len, value, report_base, hits);
+	});
+	return hits;
+}
+
+// Scan memory of a remote process for every occurrence of any value of a (built) set, aligned to the set's value size.
+// Returns the (remote) address of every occurrence, in address order.
+std::vector<void*> Memory::Remote::valueSetScan(HANDLE rmt_handle, byte* rmt_scan_addr, byte* rmt_end_addr, const ValueSet& set, uint32_t mem_type, uint32_t mem_prot) {
+	std::vector<void*> hits;
+	if (!set.size())
+		return hits;
+
+	scanRemoteRegions(rmt_handle, rmt_scan_addr, rmt_end_addr, set.valueSize(), mem_type, mem_prot, [&](const byte* buf, size_t len, byte* report_base) {
+		valueSetScanBuffer(buf, len, set, report_base, hits);
+	});
+	return hits;
+}
+
+// ------------------------
+// STRUCTURAL SCANNING
+// ------------------------
+
+// Every field is a range check on a key that orders the field's values like unsigned ints:
+//   unsigned  key = x
+//   signed    key = x ^ 0x80000000
+//   float     key = x ^ 0x80000000 for positive floats, ~x for negative ones
+// sse2 only has signed compares, so the vector path compares key ^ 0x80000000 against biased bounds.
+// The field with the narrowest range (per the region map for readable pointers) is tested first over
+// four candidates at a time, the others only run on the few candidates that survive it.
+
+Memory::StructPattern& Memory::StructPattern::intRange(uint32_t offset, int32_t min, int32_t max) {
+	return add(offset, StructField::SIGNED, static_cast<uint32_t>(min) ^ 0x80000000, static_cast<uint32_t>(max) ^ 0x80000000);
+}
+
+// Order preserving key of a float's bits.
+static inline uint32_t floatKey(uint32_t bits) {
+	return bits & 0x80000000 ? ~bits : bits ^ 0x80000000;
+}
+
+Memory::StructPattern& Memory::StructPattern::floatRange(uint32_t offset, float min, float max) {
+	// -0.0 and 0.0 have different keys, widen the range so either one matches a bound of zero.
+	if (min == 0.0f)
+		min = -0.0f;
+	if (max == -0.0f)
+		max = 0.0f;
+
+	uint32_t min_bits, max_bits;
+	memcpy(&min_bits, &min, 4);
+	memcpy(&max_bits, &max, 4);
+	return add(offset, StructField::FLOAT, floatKey(min_bits), floatKey(max_bits));
+}
+
+// The key range is filled in from the region map when the scan starts.
+Memory::StructPattern& Memory::StructPattern::pointerReadable(uint32_t offset, size_t len) {
+	return add(offset, StructField::UNSIGNED, 0, UINT32_MAX, len ? len : 1);
+}
+
+Memory::StructPattern& Memory::StructPattern::add(uint32_t offset, StructField::Kind kind, uint32_t lo, uint32_t hi, size_t readable_len) {
+	StructField field = { offset, kind, lo, hi, readable_len };
+	field_list.push_back(field);
+	span = max(span, static_cast<size_t>(offset) + 4);
+	return *this;
+}
+
+// Fields of a StructPattern ordered for one scan.
+struct StructMatcher {
+	std::vector<Memory::StructField> fields;   // Most selective first.
+	const Memory::Remote::RegionMap* map;
+	size_t size;
+	uint32_t align;
+};
+
+// Key of a field's raw value, see the top of this section.
+static inline uint32_t fieldKey(uint32_t x, Memory::StructField::Kind kind) {
+	switch (kind) {
+	case Memory::StructField::SIGNED:
+		return x ^ 0x80000000;
+	case Memory::StructField::FLOAT:
+		return floatKey(x);
+	default:
+		return x;
+	}
+}
+
+// Order the fields of a pattern by how many values pass them, and narrow readable pointer fields
+// down to the span of readable memory in the map.
+static void buildStructMatcher(StructMatcher& matcher, const Memory::StructPattern& pattern, const Memory::Remote::RegionMap* map) {
+	matcher.fields = pattern.fields();
+	matcher.map = map;
+	matcher.size = pattern.size();
+	matcher.align = pattern.alignment();
+
+	uint64_t readable_bytes = 0;
+	uint32_t readable_lo = UINT32_MAX, readable_hi = 0;
+	if (map) {
+		for (size_t i = 0; i < map->regions().size(); i++) {
+			const MEMORY_BASIC_INFORMATION& mbi = map->regions()[i];
+			if (!(mbi.Protect & PAGE_ANYREAD) || mbi.Protect & PAGE_GUARD)
+				continue;
+
+			uint32_t base = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(mbi.BaseAddress));
+			readable_bytes += mbi.RegionSize;
+			readable_lo = min(readable_lo, base);
+			readable_hi = max(readable_hi, static_cast<uint32_t>(base + mbi.RegionSize - 1));
+		}
+	}
+
+	std::vector<uint64_t> passing(matcher.fields.size());
+	for (size_t i = 0; i < matcher.fields.size(); i++) {
+		Memory::StructField& field = matcher.fields[i];
+		if (field.readable_len) {
+			field.lo = max(field.lo, readable_lo);
+			field.hi = min(field.hi, readable_hi);
+			passing[i] = readable_bytes;
+		} else {
+			passing[i] = field.hi >= field.lo ? static_cast<uint64_t>(field.hi) - field.lo + 1 : 0;
+		}
+	}
+
+	std::vector<size_t> order(matcher.fields.size());
+	for (size_t i = 0; i < order.size(); i++)
+		order[i] = i;
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return passing[a] < passing[b]; });
+
+	std::vector<Memory::StructField> sorted;
+	for (size_t i = 0; i < order.size(); i++)
+		sorted.push_back(matcher.fields[order[i]]);
+	matcher.fields.swap(sorted);
+}
+
+// Test every field after the first one against the object at obj.
+static inline bool matchRemainingFields(const byte* obj, const StructMatcher& matcher) {
+	for (size_t i = 1; i < matcher.fields.size(); i++) {
+		const Memory::StructField& field = matcher.fields[i];
+		uint32_t x = *reinterpret_cast<const uint32_t*>(obj + field.offset);
+		uint32_t key = fieldKey(x, field.kind);
+		if (key < field.lo || key > field.hi)
+			return false;
+		if (field.readable_len && !matcher.map->readable(reinterpret_cast<const void*>(static_cast<uintptr_t>(x)), field.readable_len))
+			return false;
+	}
+
+	return true;
+}
+
+// Test a whole object, used for candidates the vector path doesn't cover.
+static inline bool matchStruct(const byte* obj, const StructMatcher& matcher) {
+	const Memory::StructField& lead = matcher.fields[0];
+	uint32_t x = *reinterpret_cast<const uint32_t*>(obj + lead.offset);
+	uint32_t key = fieldKey(x, lead.kind);
+	if (key < lead.lo || key > lead.hi)
+		return false;
+	if (lead.readable_len && !matcher.map->readable(reinterpret_cast<const void*>(static_cast<uintptr_t>(x)), lead.readable_len))
+		return false;
+	return matchRemainingFields(obj, matcher);
+}
+
+// Find every object matching a StructMatcher within a local buffer.
+static void structScanBuffer(const byte* buf, size_t len, const StructMatcher& matcher, byte* report_base, std::vector<void*>& hits) {
+	if (len < matcher.size)
+		return;
+
+	size_t last = len - matcher.size;  // Last offset an object can start at.
+	size_t i = alignedStart(report_base, matcher.align);
+
+	// Four candidates per register when objects are 4, 8 or 16 byte aligned, lanes that aren't at an
+	// object boundary get masked off.
+	if (matcher.align == 4 || matcher.align == 8 || matcher.align == 16) {
+		const Memory::StructField& lead = matcher.fields[0];
+		const int lane_mask = matcher.align == 4 ? 0xF : matcher.align == 8 ? 0x5 : 0x1;
+		const __m128i bias = _mm_set1_epi32(static_cast<int>(0x80000000));
+		const __m128i lo = _mm_set1_epi32(static_cast<int>(lead.lo ^ 0x80000000));
+		const __m128i hi = _mm_set1_epi32(static_cast<int>(lead.hi ^ 0x80000000));
+		const __m128i sign_flip = _mm_set1_epi32(lead.kind == Memory::StructField::SIGNED ? 0 : static_cast<int>(0x80000000));
+		const bool is_float = lead.kind == Memory::StructField::FLOAT;
+
+		for (; i + 12 <= last; i += 16) {
+			__m128i vals = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + i + lead.offset));
+
+			// Biased key: unsigned -> x ^ bias, signed -> x, float -> x ^ (sign ? 0x7FFFFFFF : 0).
+			__m128i keys = is_float ? _mm_xor_si128(vals, _mm_andnot_si128(bias, _mm_srai_epi32(vals, 31))) : _mm_xor_si128(vals, sign_flip);
+			__m128i outside = _mm_or_si128(_mm_cmpgt_epi32(lo, keys), _mm_cmpgt_epi32(keys, hi));
+			int candidates = ~_mm_movemask_ps(_mm_castsi128_ps(outside)) & lane_mask;
+			for (size_t k = 0; candidates; k++, candidates >>= 1) {
+				if (!(candidates & 1))
+					continue;
+
+				const byte* obj = buf + i + k * 4;
+				uint32_t x = *reinterpret_cast<const uint32_t*>(obj + lead.offset);
+				if (lead.readable_len && !matcher.map->readable(reinterpret_cast<const void*>(static_cast<uintptr_t>(x)), lead.readable_len))
+					continue;
+				if (matchRemainingFields(obj, matcher))
+					hits.push_back(report_base + i + k * 4);
+			}
+		}
+	}
+
+	for (; i <= last; i += matcher.align)
+		if (matchStruct(buf + i, matcher))
+			hits.push_back(report_base + i);
+}
+
+// Scan memory locally for every object matching a field layout.
+// Arguments are the same as Memory::Local::scan, with the layout in place of data/mask.
+// map is used to check readable pointer fields, if it is 0 and the layout has any, one is made for this scan.
+// Only objects that lie entirely within [scan_addr, end_addr) are found.
+// Returns the address of every matching object, in address order.
+std::vector<void*> Memory::Local::structScan(byte* scan_addr, byte* end_addr, const StructPattern& pattern, uint32_t mem_type, uint32_t mem_prot, const Remote::RegionMap* map) {
+	std::vector<void*> hits;
+	if (pattern.fields().empty())
+		return hits;
+
+	Remote::RegionMap own_map;
+	for (size_t i = 0; !map && i < pattern.fields().size(); i++)
+		if (pattern.fields()[i].readable_len && own_map.refresh(GetCurrentProcess()))
+			map = &own_map;
+
+	StructMatcher matcher;
+	buildStructMatcher(matcher, pattern, map);
+	scanLocalRegions(scan_addr, end_addr, mem_type, mem_prot, [&](const byte* buf, size_t len, byte* report_base) {
+		structScanBuffer(buf, len, matcher, report_base, hits);
+	});
+	return hits;
+}
+
+// Scan memory of a remote process for every object matching a field layout.
+// Arguments are the same as Memory::Remote::scan, with the layout in place of data/mask.
+// map is used to check readable pointer fields, if it is 0 and the layout has any, one is made for this scan.
+// Only objects that lie entirely within [rmt_scan_addr, rmt_end_addr) are found.
+// Returns the (remote) address of every matching object, in address order.
+std::vector<void*> Memory::Remote::structScan(HANDLE rmt_handle, byte* rmt_scan_addr, byte* rmt_end_addr, const StructPattern& pattern, uint32_t mem_type, uint32_t mem_prot, const RegionMap* map) {
+	std::vector<void*> hits;
+	if (pattern.fields().empty())
+		return hits;
+
+	RegionMap own_map;
+	for (size_t i = 0; !map && i < pattern.fields().size(); i++)
+		if (pattern.fields()[i].readable_len && own_map.refresh(rmt_handle))
+			map = &own_map;
+
+	StructMatcher matcher;
+	buildStructMatcher(matcher, pattern, map);
+	scanRemoteRegions(rmt_handle, rmt_scan_addr, rmt_end_addr, matcher.size, mem_type, mem_prot, [&](const byte* buf, size_t len, byte* report_base) {
+		structScanBuffer(buf, len, matcher, report_base, hits);
+	});
+	return hits;
+}
+// ------------------------
+// TEXT SCANNING
+// ------------------------
+
+// The needle is kept in two forms: its utf-8 bytes (the "narrow" form, which is also its ascii form when
+// it has no characters past 0x7F) and its utf-16 code units (the "wide" form). Both get looked for in the
+// same pass over memory.
+//
+// Each block of 16 positions is loaded four times at offsets 0-3 and ascii letters are lowercased with
+// a range compare and an or. The narrow form's first two bytes and the wide form's first two code units
+// are compared against that, the wide form only at even addresses (utf-16 text is 2 byte aligned).
+// Only positions passing that filter get compared in full. Case folding only covers ascii letters,
+// other characters have to match exactly.
+
+// Needle prepared for textScanBuffer.
+struct TextNeedle {
+	std::vector<byte> narrow;       // utf-8 bytes, lowercased if ignoring case.
+	std::vector<uint16_t> wide;     // utf-16 code units, lowercased if ignoring case.
+	uint32_t narrow_encoding;       // TEXT_ASCII or TEXT_UTF8, 0 if the narrow form isn't looked for.
+	bool use_wide;
+	bool ignore_case;
+};
+
+static inline byte foldAscii(byte c) {
+	return c >= 'A' && c <= 'Z' ? c | 0x20 : c;
+}
+
+static inline uint16_t foldWide(uint16_t c) {
+	return c >= 'A' && c <= 'Z' ? c | 0x20 : c;
+}
+
+// Lowercase the ascii letters of 16 bytes.
+static inline __m128i foldAscii16(__m128i x) {
+	const __m128i upper_lo = _mm_set1_epi8('A' - 1);
+	const __m128i upper_hi = _mm_set1_epi8('Z' + 1);
+	const __m128i case_bit = _mm_set1_epi8(0x20);
+	__m128i upper = _mm_and_si128(_mm_cmpgt_epi8(x, upper_lo), _mm_cmpgt_epi8(upper_hi, x));
+	return _mm_or_si128(x, _mm_and_si128(upper, case_bit));
+}
+
+// Prepare the narrow and wide forms of a needle.
+// Returns false if the needle is empty, isn't valid utf-8, or none of the requested encodings can hold it.
+static bool buildTextNeedle(TextNeedle& needle, const char* text, uint32_t encodings, bool ignore_case) {
+	size_t text_len = strlen(text);
+	if (!text_len)
+		return false;
+
+	bool is_ascii = true;
+	for (size_t i = 0; i < text_len; i++)
+		if (static_cast<byte>(text[i]) >= 0x80)
+			is_ascii = false;
+
+	needle.ignore_case = ignore_case;
+	needle.narrow_encoding = 0;
+	if (is_ascii && encodings & TEXT_ASCII)
+		needle.narrow_encoding = TEXT_ASCII;
+	else if (encodings & TEXT_UTF8)
+		needle.narrow_encoding = is_ascii ? TEXT_ASCII : TEXT_UTF8;
+
+	int wide_len = MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, text, static_cast<int>(text_len), 0, 0);
+	if (wide_len <= 0)
+		return false;
+
+	needle.wide.resize(wide_len);
+	MultiByteToWideChar(CP_UTF8, MB_ERR_INVALID_CHARS, text, static_cast<int>(text_len), reinterpret_cast<wchar_t*>(&needle.wide[0]), wide_len);
+	needle.use_wide = (encodings & TEXT_UTF16LE) != 0;
+
+	needle.narrow.assign(reinterpret_cast<const byte*>(text), reinterpret_cast<const byte*>(text) + text_len);
+	if (ignore_case) {
+		for (size_t i = 0; i < needle.narrow.size(); i++)
+			needle.narrow[i] = foldAscii(needle.narrow[i]);
+		for (size_t i = 0; i < needle.wide.size(); i++)
+			needle.wide[i] = foldWide(needle.wide[i]);
+	}
+
+	return needle.narrow_encoding || needle.use_wide;
+}
+
+// Longest match of a needle in bytes.
+static inline size_t textNeedleSpan(const TextNeedle& needle) {
+	return max(needle.narrow_encoding ? needle.narrow.size() : 0, needle.use_wide ? needle.wide.size() * 2 : 0);
+}
+
+static inline bool matchNarrow(const byte* s, size_t avail, const TextNeedle& needle) {
+	if (avail < needle.narrow.size())
+		return false;
+
+	for (size_t j = 0; j < needle.narrow.size(); j++)
+		if ((needle.ignore_case ? foldAscii(s[j]) : s[j]) != needle.narrow[j])
+			return false;
+	return true;
+}
+
+static inline bool matchWide(const byte* s, size_t avail, const TextNeedle& needle) {
+	if (avail < needle.wide.size() * 2)
+		return false;
+
+	for (size_t j = 0; j < needle.wide.size(); j++) {
+		uint16_t c = static_cast<uint16_t>(s[j * 2] | s[j * 2 + 1] << 8);
+		if ((needle.ignore_case ? foldWide(c) : c) != needle.wide[j])
+			return false;
+	}
+	return true;
+}
+
+// Check both forms of the needle at one position and record a hit for each that matches.
+// They can both match, e.g. a single character needle matches the first byte of its wide form.
+static inline void checkTextCandidate(const byte* buf, size_t len, size_t i, bool narrow, bool wide, const TextNeedle& needle, byte* report_base, std::vector<Memory::TextHit>& hits) {
+	if (narrow && matchNarrow(buf + i, len - i, needle))
+		hits.push_back({ report_base + i, needle.narrow_encoding, needle.narrow.size() });
+	if (wide && matchWide(buf + i, len - i, needle))
+		hits.push_back({ report_base + i, TEXT_UTF16LE, needle.wide.size() * 2 });
+}
+
+// Find every occurrence of a needle within a local buffer.
+static void textScanBuffer(const byte* buf, size_t len, const TextNeedle& needle, byte* report_base, std::vector<Memory::TextHit>& hits) {
+	bool narrow = needle.narrow_encoding != 0;
+	bool wide = needle.use_wide;
+	size_t parity = reinterpret_cast<uintptr_t>(report_base) & 1;  // Offsets with this parity are even addresses.
+	size_t i = 0;
+
+	// Needles of a single byte or code unit only filter on that.
+	// Low bytes of the wide form are folded like the buffer bytes they're compared against.
+	bool narrow_two = needle.narrow.size() > 1;
+	bool wide_two = needle.wide.size() > 1;
+	const __m128i n0 = _mm_set1_epi8(static_cast<char>(needle.narrow[0]));
+	const __m128i n1 = _mm_set1_epi8(static_cast<char>(narrow_two ? needle.narrow[1] : 0));
+	const byte wide_lo0 = static_cast<byte>(needle.wide[0] & 0xFF);
+	const byte wide_lo1 = static_cast<byte>(wide_two ? needle.wide[1] & 0xFF : 0);
+	const __m128i w0_lo = _mm_set1_epi8(static_cast<char>(needle.ignore_case ? foldAscii(wide_lo0) : wide_lo0));
+	const __m128i w0_hi = _mm_set1_epi8(static_cast<char>(needle.wide[0] >> 8));
+	const __m128i w1_lo = _mm_set1_epi8(static_cast<char>(needle.ignore_case ? foldAscii(wide_lo1) : wide_lo1));
+	const __m128i w1_hi = _mm_set1_epi8(static_cast<char>(wide_two ? needle.wide[1] >> 8 : 0));
+	const __m128i ones = _mm_set1_epi8(-1);
+	const int even_mask = parity ? 0xAAAA : 0x5555;
+
+	for (; i + 19 <= len; i += 16) {
+		// Most blocks don't contain the first byte of either form at all.
+		__m128i f0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + i));
+		if (needle.ignore_case)
+			f0 = foldAscii16(f0);
+		__m128i first_narrow = narrow ? _mm_cmpeq_epi8(f0, n0) : _mm_setzero_si128();
+		__m128i first_wide = wide ? _mm_cmpeq_epi8(f0, w0_lo) : _mm_setzero_si128();
+		if (!_mm_movemask_epi8(_mm_or_si128(first_narrow, first_wide)))
+			continue;
+
+		__m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + i + 1));
+		__m128i v2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + i + 2));
+		__m128i v3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(buf + i + 3));
+		__m128i f1 = v1, f2 = v2;
+		if (needle.ignore_case) {
+			f1 = foldAscii16(v1);
+			f2 = foldAscii16(v2);
+		}
+
+		int narrow_hits = 0, wide_hits = 0;
+		if (narrow)
+			narrow_hits = _mm_movemask_epi8(_mm_and_si128(first_narrow, narrow_two ? _mm_cmpeq_epi8(f1, n1) : ones));
+		if (wide) {
+			// High bytes are compared unfolded, they're never ascii letters of the needle.
+			__m128i first = _mm_and_si128(first_wide, _mm_cmpeq_epi8(v1, w0_hi));
+			__m128i second = wide_two ? _mm_and_si128(_mm_cmpeq_epi8(f2, w1_lo), _mm_cmpeq_epi8(v3, w1_hi)) : ones;
+			wide_hits = _mm_movemask_epi8(_mm_and_si128(first, second)) & even_mask;
+		}
+
+		for (int candidates = narrow_hits | wide_hits; candidates; candidates &= candidates - 1) {
+			unsigned long k;
+			_BitScanForward(&k, candidates);
+			checkTextCandidate(buf, len, i + k, (narrow_hits >> k & 1) != 0, (wide_hits >> k & 1) != 0, needle, report_base, hits);
+		}
+	}
+
+	for (; i < len; i++)
+		checkTextCandidate(buf, len, i, narrow, wide && (i & 1) == parity, needle, report_base, hits);
+}
+
+// Scan memory locally for a string in several encodings at once.
+// text is the (utf-8) string to look for. encodings is any combination of TEXT_ASCII, TEXT_UTF8 and
+// TEXT_UTF16LE. A string without characters past 0x7F has the same bytes in ascii and utf-8, those
+// matches are reported as TEXT_ASCII. utf-16 matches are only found at 2 byte aligned addresses.
+// If ignore_case is set ascii letters match regardless of case, other characters must match exactly.
+// Other arguments are the same as Memory::Local::scan.
+// Returns every match with the encoding it was found in, in address order.
+std::vector<Memory::TextHit> Memory::Local::textScan(byte* scan_addr, byte* end_addr, const char* text, uint32_t encodings, bool ignore_case, uint32_t mem_type, uint32_t mem_prot) {
+	std::vector<TextHit> hits;
+	TextNeedle needle;
+	if (!buildTextNeedle(needle, text, encodings, ignore_case))
+		return hits;
+
+	scanLocalRegions(scan_addr, end_addr, mem_type, mem_prot, [&](const byte* buf, size_t len, byte* report_base) {
+		textScanBuffer(buf, len, needle, report_base, hits);
+	});
+	return hits;
+}
+
+// Scan memory of a remote process for a string in several encodings at once.
+// Arguments and results are the same as Memory::Local::textScan, with (remote) addresses.
+std::vector<Memory::TextHit> Memory::Remote::textScan(HANDLE rmt_handle, byte* rmt_scan_addr, byte* rmt_end_addr, const char* text, uint32_t encodings, bool ignore_case, uint32_t mem_type, uint32_t mem_prot) {
+	std::vector<TextHit> hits;
+	TextNeedle needle;
+	if (!buildTextNeedle(needle, text, encodings, ignore_case))
+		return hits;
+
+	// Chunks overlap by the longer form of the needle, so the shorter one can be found twice near a
+	// chunk boundary. Hits come in address order, the narrow one first where both forms match at one
+	// address, so anything at or before the last hit in that order is a repeat.
+	std::vector<TextHit> chunk_hits;
+	scanRemoteRegions(rmt_handle, rmt_scan_addr, rmt_end_addr, textNeedleSpan(needle), mem_type, mem_prot, [&](const byte* buf, size_t len, byte* report_base) {
+		chunk_hits.clear();
+		textScanBuffer(buf, len, needle, report_base, chunk_hits);
+		for (size_t i = 0; i < chunk_hits.size(); i++) {
+			const TextHit& hit = chunk_hits[i];
+			if (hits.empty() || hit.addr > hits.back().addr || (hit.addr == hits.back().addr && hit.encoding == TEXT_UTF16LE && hits.back().encoding != TEXT_UTF16LE))
+				hits.push_back(hit);
+		}
+	});
+	return hits;
+}
\ No newline at end of file
@@ -0,0 +1,287 @@
+#pragma once
+#include <stdint.h>
+#include <Windows.h>
+#include <vector>
+
+#include "win32memory.hpp"
+
+// Largest mismatch count fuzzyScan accepts.
+#define FUZZY_MAX_MISMATCHES 15
+
+// Text encodings for textScan, can be or'd together.
+#define TEXT_ASCII    0x1
+#define TEXT_UTF8     0x2
+#define TEXT_UTF16LE  0x4
+#define TEXT_ANY      (TEXT_ASCII | TEXT_UTF8 | TEXT_UTF16LE)
+
+namespace Memory {
+	// A single result of a fuzzy scan.
+	struct FuzzyHit {
+		void* addr;           // Address the pattern starts at.
+		uint32_t mismatches;  // Number of fixed ("x") bytes of the pattern that did not match.
+	};
+
+	// A set of 4 or 8 byte values for valueSetScan, looked up through a perfect hash.
+	// Add values, then call build() once before scanning with it.
+	class ValueSet {
+	public:
+		explicit ValueSet(size_t value_size = 4);
+
+		// Add a value to the set (only the low value_size bytes are used).
+		void add(uint64_t value);
+
+		// Build the hash. Returns false if the set is empty.
+		bool build();
+
+		// Whether value is in the set. Only valid after build().
+		inline bool contains(uint64_t value) const {
+			uint32_t mix = value_size == 4 ? static_cast<uint32_t>(value) : static_cast<uint32_t>((value * mix_mul) >> 32);
+			uint32_t bucket = static_cast<uint32_t>(static_cast<uint64_t>(mix * bucket_mul) >> bucket_shift);
+			uint32_t slot = ((mix * slot_mul) >> slot_shift) + disp[bucket];
+			return table[slot & slot_mask] == value;
+		}
+
+		size_t valueSize() const { return value_size; }
+		size_t size() const { return values.size(); }
+		uint64_t minValue() const { return min_value; }
+		uint64_t maxValue() const { return max_value; }
+
+	private:
+		size_t value_size;
+		std::vector<uint64_t> values;
+
+		// Hash and displace: a value's bucket picks a displacement that is added to its slot hash.
+		// Every slot holds one value of the set, so a lookup is two multiplies and one compare.
+		std::vector<uint64_t> table;
+		std::vector<uint32_t> disp;
+		uint64_t mix_mul;       // Folds 8 byte values down to 32 bits.
+		uint32_t bucket_mul;
+		uint32_t bucket_shift;  // 32 - log2(bucket count), can be 32.
+		uint32_t slot_mul;
+		uint32_t slot_shift;
+		uint32_t slot_mask;
+		uint64_t min_value;
+		uint64_t max_value;
+	};
+
+	// A single result of a text scan. Where the text matches in more than one encoding at the same address
+	// (a single character matches the start of its UTF-16 form), there is a result for each.
+	struct TextHit {
+		void* addr;          // Address the text starts at.
+		uint32_t encoding;   // TEXT_ASCII, TEXT_UTF8 or TEXT_UTF16LE.
+		size_t len;          // Length of the match in bytes.
+	};
+
+	// A field of a StructPattern.
+	// Every field is a 4 byte value whose order preserving key must lie in [lo, hi], see StructPattern.
+	struct StructField {
+		enum Kind { UNSIGNED, SIGNED, FLOAT };
+
+		uint32_t offset;
+		Kind kind;
+		uint32_t lo;              // Key range, in unsigned order.
+		uint32_t hi;
+		size_t readable_len;      // If non-zero, the value must also point to this many readable bytes.
+	};
+
+	// A typed field layout to scan for, e.g. "pointer into module X at +0, int between 1 and 100 at +8, float at +12".
+	// Signed ints and floats are mapped to keys that sort like unsigned ints, so every field test is one range check.
+	class StructPattern {
+	public:
+		// align is the alignment of the objects being looked for.
+		explicit StructPattern(uint32_t align = 4) : align(align ? align : 1), span(0) {}
+
+		// 4 byte value at offset equals value.
+		StructPattern& equals(uint32_t offset, uint32_t value) { return add(offset, StructField::UNSIGNED, value, value); }
+
+		// Signed int at offset is within [min, max].
+		StructPattern& intRange(uint32_t offset, int32_t min, int32_t max);
+
+		// Unsigned int at offset is within [min, max].
+		StructPattern& uintRange(uint32_t offset, uint32_t min, uint32_t max) { return add(offset, StructField::UNSIGNED, min, max); }
+
+		// Float at offset is within [min, max] (never matches NaN).
+		StructPattern& floatRange(uint32_t offset, float min, float max);
+
+		// Pointer at offset points into [rmt_start, rmt_end).
+		StructPattern& pointerInto(uint32_t offset, uint32_t rmt_start, uint32_t rmt_end) { return add(offset, StructField::UNSIGNED, rmt_start, rmt_end - 1); }
+
+		// Pointer at offset points into a module.
+		StructPattern& pointerInto(uint32_t offset, const Remote::ModuleInfo& module) { return pointerInto(offset, module.base, module.base + module.size); }
+
+		// Pointer at offset points to at least len readable bytes.
+		StructPattern& pointerReadable(uint32_t offset, size_t len = 4);
+
+		// Number of bytes from the start of the object to the end of its last field.
+		size_t size() const { return span; }
+		uint32_t alignment() const { return align; }
+		const std::vector<StructField>& fields() const { return field_list; }
+
+	private:
+		uint32_t align;
+		size_t span;
+		std::vector<StructField> field_list;
+
+		StructPattern& add(uint32_t offset, StructField::Kind kind, uint32_t lo, uint32_t hi, size_t readable_len = 0);
+	};
+
+	namespace Local {
+		// Scan memory locally for a pattern, tolerating up to max_mismatches differing fixed bytes.
+		std::vector<FuzzyHit> fuzzyScan(byte* start_addr, byte* end_addr, const char* data, const char* mask, uint32_t max_mismatches, uint32_t mem_type, uint32_t mem_prot);
+
+		// Scan memory locally for a pattern, tolerating up to max_mismatches differing fixed bytes.
+		inline std::vector<FuzzyHit> fuzzyScan(void* start_addr, void* end_addr, const char* data, const char* mask, uint32_t max_mismatches, uint32_t mem_type, uint32_t mem_prot) {
+			return fuzzyScan(static_cast<byte*>(start_addr), static_cast<byte*>(end_addr), data, mask, max_mismatches, mem_type, mem_prot);
+		}
+
+		// Scan memory locally for a pattern, tolerating up to max_mismatches differing fixed bytes.
+		inline std::vector<FuzzyHit> fuzzyScan(uint32_t start_addr, uint32_t end_addr, const char* data, const char* mask, uint32_t max_mismatches, uint32_t mem_type, uint32_t mem_prot) {
+			return fuzzyScan(reinterpret_cast<byte*>(start_addr), reinterpret_cast<byte*>(end_addr), data, mask, max_mismatches, mem_type, mem_prot);
+		}
+
+		// Scan memory locally for every 4-byte aligned occurrence of a 4 byte value.
+		std::vector<void*> valueScan(byte* start_addr, byte* end_addr, uint32_t value, uint32_t mem_type, uint32_t mem_prot);
+
+		// Scan memory locally for every 4-byte aligned occurrence of a 4 byte value.
+		inline std::vector<void*> valueScan(void* start_addr, void* end_addr, uint32_t value, uint32_t mem_type, uint32_t mem_prot) {
+			return valueScan(static_cast<byte*>(start_addr), static_cast<byte*>(end_addr), value, mem_type, mem_prot);
+		}
+
+		// Scan memory locally for every 4-byte aligned occurrence of a 4 byte value.
+		inline std::vector<void*> valueScan(uint32_t start_addr, uint32_t end_addr, uint32_t value, uint32_t mem_type, uint32_t mem_prot) {
+			return valueScan(reinterpret_cast<byte*>(start_addr), reinterpret_cast<byte*>(end_addr), value, mem_type, mem_prot);
+		}
+
+		// Scan memory locally for every 8-byte aligned occurrence of an 8 byte value.
+		std::vector<void*> valueScan64(byte* start_addr, byte* end_addr, uint64_t value, uint32_t mem_type, uint32_t mem_prot);
+
+		// Scan memory locally for every 8-byte aligned occurrence of an 8 byte value.
+		inline std::vector<void*> valueScan64(void* start_addr, void* end_addr, uint64_t value, uint32_t mem_type, uint32_t mem_prot) {
+			return valueScan64(static_cast<byte*>(start_addr), static_cast<byte*>(end_addr), value, mem_type, mem_prot);
+		}
+
+		// Scan memory locally for every 8-byte aligned occurrence of an 8 byte value.
+		inline std::vector<void*> valueScan64(uint32_t start_addr, uint32_t end_addr, uint64_t value, uint32_t mem_type, uint32_t mem_prot) {
+			return valueScan64(reinterpret_cast<byte*>(start_addr), reinterpret_cast<byte*>(end_addr), value, mem_type, mem_prot);
+		}
+
+		// Scan memory locally for every aligned occurrence of any value of a set.
+		std::vector<void*> valueSetScan(byte* start_addr, byte* end_addr, const ValueSet& set, uint32_t mem_type, uint32_t mem_prot);
+
+		// Scan memory locally for every aligned occurrence of any value of a set.
+		inline std::vector<void*> valueSetScan(void* start_addr, void* end_addr, const ValueSet& set, uint32_t mem_type, uint32_t mem_prot) {
+			return valueSetScan(static_cast<byte*>(start_addr), static_cast<byte*>(end_addr), set, mem_type, mem_prot);
+		}
+
+		// Scan memory locally for every aligned occurrence of any value of a set.
+		inline std::vector<void*> valueSetScan(uint32_t start_addr, uint32_t end_addr, const ValueSet& set, uint32_t mem_type, uint32_t mem_prot) {
+			return valueSetScan(reinterpret_cast<byte*>(start_addr), reinterpret_cast<byte*>(end_addr), set, mem_type, mem_prot);
+		}
+
+		// Scan memory locally for every object matching a field layout.
+		std::vector<void*> structScan(byte* start_addr, byte* end_addr, const StructPattern& pattern, uint32_t mem_type, uint32_t mem_prot, const Remote::RegionMap* map = 0);
+
+		// Scan memory locally for every object matching a field layout.
+		inline std::vector<void*> structScan(void* start_addr, void* end_addr, const StructPattern& pattern, uint32_t mem_type, uint32_t mem_prot, const Remote::RegionMap* map = 0) {
+			return structScan(static_cast<byte*>(start_addr), static_cast<byte*>(end_addr), pattern, mem_type, mem_prot, map);
+		}
+
+		// Scan memory locally for every object matching a field layout.
+		inline std::vector<void*> structScan(uint32_t start_addr, uint32_t end_addr, const StructPattern& pattern, uint32_t mem_type, uint32_t mem_prot, const Remote::RegionMap* map = 0) {
+			return structScan(reinterpret_cast<byte*>(start_addr), reinterpret_cast<byte*>(end_addr), pattern, mem_type, mem_prot, map);
+		}
+
+		// Scan memory locally for a (utf-8) string in any of the given encodings at once.
+		std::vector<TextHit> textScan(byte* start_addr, byte* end_addr, const char* text, uint32_t encodings, bool ignore_case, uint32_t mem_type, uint32_t mem_prot);
+
+		// Scan memory locally for a (utf-8) string in any of the given encodings at once.
+		inline std::vector<TextHit> textScan(void* start_addr, void* end_addr, const char* text, uint32_t encodings, bool ignore_case, uint32_t mem_type, uint32_t mem_prot) {
+			return textScan(static_cast<byte*>(start_addr), static_cast<byte*>(end_addr), text, encodings, ignore_case, mem_type, mem_prot);
+		}
+
+		// Scan memory locally for a (utf-8) string in any of the given encodings at once.
+		inline std::vector<TextHit> textScan(uint32_t start_addr, uint32_t end_addr, const char* text, uint32_t encodings, bool ignore_case, uint32_t mem_type, uint32_t mem_prot) {
+			return textScan(reinterpret_cast<byte*>(start_addr), reinterpret_cast<byte*>(end_addr), text, encodings, ignore_case, mem_type, mem_prot);
+		}
+	}
+
+	namespace Remote {
+		// Scan memory of a remote process for a pattern, tolerating up to max_mismatches differing fixed bytes.
+		std::vector<FuzzyHit> fuzzyScan(HANDLE rmt_handle, byte* rmt_start_addr, byte* rmt_end_addr, const char* data, const char* mask, uint32_t max_mismatches, uint32_t mem_type, uint32_t mem_prot);
+
+		// Scan memory of a remote process for a pattern, tolerating up to max_mismatches differing fixed bytes.
+		inline std::vector<FuzzyHit> fuzzyScan(HANDLE rmt_handle, void* rmt_start_addr, void* rmt_end_addr, const char* data, const char* mask, uint32_t max_mismatches, uint32_t mem_type, uint32_t mem_prot) {
+			return fuzzyScan(rmt_handle, static_cast<byte*>(rmt_start_addr), static_cast<byte*>(rmt_end_addr), data, mask, max_mismatches, mem_type, mem_prot);
+		}
+
+		// Scan memory of a remote process for a pattern, tolerating up to max_mismatches differing fixed bytes.
+		inline std::vector<FuzzyHit> fuzzyScan(HANDLE rmt_handle, uint32_t rmt_start_addr, uint32_t rmt_end_addr, const char* data, const char* mask, uint32_t max_mismatches, uint32_t mem_type, uint32_t mem_prot) {
+			return fuzzyScan(rmt_handle, reinterpret_cast<byte*>(rmt_start_addr), reinterpret_cast<byte*>(rmt_end_addr), data, mask, max_mismatches, mem_type, mem_prot);
+		}
+
+		// Scan memory of a remote process for every 4-byte aligned occurrence of a 4 byte value.
+		std::vector<void*> valueScan(HANDLE rmt_handle, byte* rmt_start_addr, byte* rmt_end_addr, uint32_t value, uint32_t mem_type, uint32_t mem_prot);
+
+		// Scan memory of a remote process for every 4-byte aligned occurrence of a 4 byte value.
+		inline std::vector<void*> valueScan(HANDLE rmt_handle, void* rmt_start_addr, void* rmt_end_addr, uint32_t value, uint32_t mem_type, uint32_t mem_prot) {
+			return valueScan(rmt_handle, static_cast<byte*>(rmt_start_addr), static_cast<byte*>(rmt_end_addr), value, mem_type, mem_prot);
+		}
+
+		// Scan memory of a remote process for every 4-byte aligned occurrence of a 4 byte value.
+		inline std::vector<void*> valueScan(HANDLE rmt_handle, uint32_t rmt_start_addr, uint32_t rmt_end_addr, uint32_t value, uint32_t mem_type, uint32_t mem_prot) {
+			return valueScan(rmt_handle, reinterpret_cast<byte*>(rmt_start_addr), reinterpret_cast<byte*>(rmt_end_addr), value, mem_type, mem_prot);
+		}
+
+		// Scan memory of a remote process for every 8-byte aligned occurrence of an 8 byte value.
+		std::vector<void*> valueScan64(HANDLE rmt_handle, byte* rmt_start_addr, byte* rmt_end_addr, uint64_t value, uint32_t mem_type, uint32_t mem_prot);
+
+		// Scan memory of a remote process for every 8-byte aligned occurrence of an 8 byte value.
+		inline std::vector<void*> valueScan64(HANDLE rmt_handle, void* rmt_start_addr, void* rmt_end_addr, uint64_t value, uint32_t mem_type, uint32_t mem_prot) {
+			return valueScan64(rmt_handle, static_cast<byte*>(rmt_start_addr), static_cast<byte*>(rmt_end_addr), value, mem_type, mem_prot);
+		}
+
+		// Scan memory of a remote process for every 8-byte aligned occurrence of an 8 byte value.
+		inline std::vector<void*> valueScan64(HANDLE rmt_handle, uint32_t rmt_start_addr, uint32_t rmt_end_addr, uint64_t value, uint32_t mem_type, uint32_t mem_prot) {
+			return valueScan64(rmt_handle, reinterpret_cast<byte*>(rmt_start_addr), reinterpret_cast<byte*>(rmt_end_addr), value, mem_type, mem_prot);
+		}
+
+		// Scan memory of a remote process for every aligned occurrence of any value of a set.
+		std::vector<void*> valueSetScan(HANDLE rmt_handle, byte* rmt_start_addr, byte* rmt_end_addr, const ValueSet& set, uint32_t mem_type, uint32_t mem_prot);
+
+		// Scan memory of a remote process for every aligned occurrence of any value of a set.
+		inline std::vector<void*> valueSetScan(HANDLE rmt_handle, void* rmt_start_addr, void* rmt_end_addr, const ValueSet& set, uint32_t mem_type, uint32_t mem_prot) {
+			return valueSetScan(rmt_handle, static_cast<byte*>(rmt_start_addr), static_cast<byte*>(rmt_end_addr), set, mem_type, mem_prot);
+		}
+
+		// Scan memory of a remote process for every aligned occurrence of any value of a set.
+		inline std::vector<void*> valueSetScan(HANDLE rmt_handle, uint32_t rmt_start_addr, uint32_t rmt_end_addr, const ValueSet& set, uint32_t mem_type, uint32_t mem_prot) {
+			return valueSetScan(rmt_handle, reinterpret_cast<byte*>(rmt_start_addr), reinterpret_cast<byte*>(rmt_end_addr), set, mem_type, mem_prot);
+		}
+
+		// Scan memory of a remote process for every object matching a field layout.
+		std::vector<void*> structScan(HANDLE rmt_handle, byte* rmt_start_addr, byte* rmt_end_addr, const StructPattern& pattern, uint32_t mem_type, uint32_t mem_prot, const RegionMap* map = 0);
+
+		// Scan memory of a remote process for every object matching a field layout.
+		inline std::vector<void*> structScan(HANDLE rmt_handle, void* rmt_start_addr, void* rmt_end_addr, const StructPattern& pattern, uint32_t mem_type, uint32_t mem_prot, const RegionMap* map = 0) {
+			return structScan(rmt_handle, static_cast<byte*>(rmt_start_addr), static_cast<byte*>(rmt_end_addr), pattern, mem_type, mem_prot, map);
+		}
+
+		// Scan memory of a remote process for every object matching a field layout.
+		inline std::vector<void*> structScan(HANDLE rmt_handle, uint32_t rmt_start_addr, uint32_t rmt_end_addr, const StructPattern& pattern, uint32_t mem_type, uint32_t mem_prot, const RegionMap* map = 0) {
+			return structScan(rmt_handle, reinterpret_cast<byte*>(rmt_start_addr), reinterpret_cast<byte*>(rmt_end_addr), pattern, mem_type, mem_prot, map);
+		}
+
+		// Scan memory of a remote process for a (utf-8) string in any of the given encodings at once.
+		std::vector<TextHit> textScan(HANDLE rmt_handle, byte* rmt_start_addr, byte* rmt_end_addr, const char* text, uint32_t encodings, bool ignore_case, uint32_t mem_type, uint32_t mem_prot);
+
+		// Scan memory of a remote process for a (utf-8) string in any of the given encodings at once.
+		inline std::vector<TextHit> textScan(HANDLE rmt_handle, void* rmt_start_addr, void* rmt_end_addr, const char* text, uint32_t encodings, bool ignore_case, uint32_t mem_type, uint32_t mem_prot) {
+			return textScan(rmt_handle, static_cast<byte*>(rmt_start_addr), static_cast<byte*>(rmt_end_addr), text, encodings, ignore_case, mem_type, mem_prot);
+		}
+
+		// Scan memory of a remote process for a (utf-8) string in any of the given encodings at once.
+		inline std::vector<TextHit> textScan(HANDLE rmt_handle, uint32_t rmt_start_addr, uint32_t rmt_end_addr, const char* text, uint32_t encodings, bool ignore_case, uint32_t mem_type, uint32_t mem_prot) {
+			return textScan(rmt_handle, reinterpret_cast<byte*>(rmt_start_addr), reinterpret_cast<byte*>(rmt_end_addr), text, encodings, ignore_case, mem_type, mem_prot);
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,188 @@
+#include "win32strpool.hpp"
+
+// End of a hash chain.
+#define STRPOOL_NO_ENTRY  UINT32_MAX
+
+// FNV-1a of a string's bytes.
+static uint64_t hashString(const void* data, size_t len) {
+	const byte* p = static_cast<const byte*>(data);
+	uint64_t hash = 0xCBF29CE484222325ull;
+	for (size_t i = 0; i < len; i++)
+		hash = (hash ^ p[i]) * 0x100000001B3ull;
+	return hash;
+}
+
+// ------------------------
+// STRING POOL
+// ------------------------
+
+Memory::StringPool::StringPool(HANDLE rmt_handle, size_t page_size) : handle(rmt_handle), page_size(page_size), page_pos(0), page_left(0), current_generation(0) {
+	memset(&pool_stats, 0, sizeof(pool_stats));
+}
+
+Memory::StringPool::~StringPool() {
+	release();
+}
+
+char* Memory::StringPool::intern(const char* local_src) {
+	return static_cast<char*>(intern(local_src, strlen(local_src) + 1, 1));
+}
+
+wchar_t* Memory::StringPool::intern(const wchar_t* local_src) {
+	return static_cast<wchar_t*>(intern(local_src, (wcslen(local_src) + 1) * sizeof(wchar_t), sizeof(wchar_t)));
+}
+
+// A narrow and a wide string never have the same bytes (only the wide one ends in two zero bytes),
+// so both kinds share one table.
+void* Memory::StringPool::intern(const void* local_src, size_t len, size_t align) {
+	uint64_t hash = hashString(local_src, len);
+	auto chain = by_hash.find(hash);
+	if (chain != by_hash.end()) {
+		for (uint32_t i = chain->second; i != STRPOOL_NO_ENTRY; i = entries[i].next) {
+			Entry& entry = entries[i];
+			if (entry.text.size() == len && !memcmp(entry.text.data(), local_src, len)) {
+				entry.refs++;
+				entry.generation = current_generation;
+				pool_stats.hits++;
+				return reinterpret_cast<void*>(entry.rmt_addr);
+			}
+		}
+	}
+
+	pool_stats.misses++;
+	uint32_t rmt_addr = place(len, align);
+	if (!rmt_addr)
+		return 0;
+
+	pool_stats.syscalls++;
+	if (!WriteProcessMemory(handle, reinterpret_cast<void*>(rmt_addr), local_src, len, 0)) {
+		free_spans.insert(std::make_pair(static_cast<uint32_t>(len), rmt_addr));
+		return 0;
+	}
+
+	uint32_t idx;
+	if (free_entries.empty()) {
+		idx = static_cast<uint32_t>(entries.size());
+		entries.push_back(Entry());
+	} else {
+		idx = free_entries.back();
+		free_entries.pop_back();
+	}
+
+	Entry& entry = entries[idx];
+	entry.text.assign(static_cast<const char*>(local_src), len);
+	entry.hash = hash;
+	entry.rmt_addr = rmt_addr;
+	entry.refs = 1;
+	entry.generation = current_generation;
+	entry.next = chain != by_hash.end() ? chain->second : STRPOOL_NO_ENTRY;
+	by_hash[hash] = idx;
+	by_addr[rmt_addr] = idx;
+	pool_stats.strings++;
+	pool_stats.bytes += len;
+	return reinterpret_cast<void*>(rmt_addr);
+}
+
+// Find (remote) space for len bytes: the smallest collected span that fits, else the end of the last page.
+// What's left of a span after placing a string goes back to the free spans.
+uint32_t Memory::StringPool::place(size_t len, size_t align) {
+	auto span = free_spans.lower_bound(static_cast<uint32_t>(len));
+	for (; span != free_spans.end(); ++span) {
+		uint32_t pad = (align - span->second % align) % align;
+		if (span->first < len + pad)
+			continue;
+
+		uint32_t rmt_addr = span->second + pad;
+		uint32_t rest = span->first - pad - static_cast<uint32_t>(len);
+		free_spans.erase(span);
+		if (rest >= 2)
+			free_spans.insert(std::make_pair(rest, rmt_addr + static_cast<uint32_t>(len)));
+		return rmt_addr;
+	}
+
+	uint32_t pad = (align - page_pos % align) % align;
+	if (len + pad > page_left) {
+		size_t size = max(page_size, (len + 0xFFFF) & ~static_cast<size_t>(0xFFFF));
+		void* page = VirtualAllocEx(handle, 0, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+		pool_stats.syscalls++;
+		if (!page)
+			return 0;
+
+		// Keep the rest of the old page for small strings.
+		if (page_left >= 2)
+			free_spans.insert(std::make_pair(page_left, page_pos));
+		pages.push_back(page);
+		pool_stats.pages++;
+		page_pos = reinterpret_cast<uint32_t>(page);
+		page_left = static_cast<uint32_t>(size);
+		pad = 0;
+	}
+
+	uint32_t rmt_addr = page_pos + pad;
+	page_pos += pad + static_cast<uint32_t>(len);
+	page_left -= pad + static_cast<uint32_t>(len);
+	return rmt_addr;
+}
+
+bool Memory::StringPool::unref(const void* rmt_str) {
+	auto it = by_addr.find(reinterpret_cast<uint32_t>(rmt_str));
+	if (it == by_addr.end() || !entries[it->second].refs)
+		return false;
+	entries[it->second].refs--;
+	return true;
+}
+
+// Take an entry out of its hash chain and the address table, and give its space back.
+void Memory::StringPool::unlink(uint32_t idx) {
+	Entry& entry = entries[idx];
+	auto chain = by_hash.find(entry.hash);
+	if (chain->second == idx) {
+		if (entry.next == STRPOOL_NO_ENTRY)
+			by_hash.erase(chain);
+		else
+			chain->second = entry.next;
+	} else {
+		uint32_t prev = chain->second;
+		while (entries[prev].next != idx)
+			prev = entries[prev].next;
+		entries[prev].next = entry.next;
+	}
+
+	by_addr.erase(entry.rmt_addr);
+	free_spans.insert(std::make_pair(static_cast<uint32_t>(entry.text.size()), entry.rmt_addr));
+	pool_stats.strings--;
+	pool_stats.bytes -= entry.text.size();
+	entry.rmt_addr = 0;
+	entry.text.clear();
+	free_entries.push_back(idx);
+}
+
+size_t Memory::StringPool::collect(uint32_t max_age) {
+	size_t freed = 0;
+	for (uint32_t i = 0; i < entries.size(); i++) {
+		Entry& entry = entries[i];
+		if (!entry.rmt_addr || entry.refs || current_generation - entry.generation < max_age)
+			continue;
+		unlink(i);
+		freed++;
+	}
+	pool_stats.collected += freed;
+	return freed;
+}
+
+void Memory::StringPool::release() {
+	for (size_t i = 0; i < pages.size(); i++)
+		VirtualFreeEx(handle, pages[i], 0, MEM_RELEASE);
+	pool_stats.syscalls += pages.size();
+	pages.clear();
+	page_pos = 0;
+	page_left = 0;
+	free_spans.clear();
+	entries.clear();
+	free_entries.clear();
+	by_hash.clear();
+	by_addr.clear();
+	pool_stats.strings = 0;
+	pool_stats.bytes = 0;
+	pool_stats.pages = 0;
+}
\ No newline at end of file
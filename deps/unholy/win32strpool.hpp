@@ -0,0 +1,94 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <wchar.h>
+#include <Windows.h>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "win32memory.hpp"
+
+// Size of the pages a StringPool packs strings into.
+#define STRPOOL_PAGE_SIZE  0x10000
+
+namespace Memory {
+	// Counters of a StringPool.
+	struct StringPoolStats {
+		size_t strings;    // Strings in the pool, referenced or not.
+		size_t bytes;      // Remote bytes they take up.
+		size_t pages;      // Pages allocated in the target.
+		size_t hits;       // intern calls that found their string pooled.
+		size_t misses;     // intern calls that had to write their string.
+		size_t collected;  // Strings freed by collect.
+		size_t syscalls;   // VirtualAllocEx / WriteProcessMemory / VirtualFreeEx calls.
+	};
+
+	// Pool of strings written to a remote process, each distinct string once.
+	// Strings are packed back to back into pages allocated in the target, so interning a string that is
+	// already pooled is a hash lookup, and a new one costs a single WriteProcessMemory.
+	// intern takes a reference and unref gives it back. Strings without references stay pooled (and
+	// free to intern again) until collect frees them, which can be limited to strings that haven't been
+	// interned for a number of generations. Not thread safe.
+	//   Memory::StringPool pool(handle);
+	//   char* rmt_name = pool.intern("player");  // Same pointer on every call.
+	class StringPool {
+	public:
+		explicit StringPool(HANDLE rmt_handle, size_t page_size = STRPOOL_PAGE_SIZE);
+		~StringPool();
+
+		StringPool(const StringPool&) = delete;
+		StringPool& operator=(const StringPool&) = delete;
+
+		// Remote copy of a local string, including its terminator. Returns 0 if it couldn't be written.
+		char* intern(const char* local_src);
+
+		// Remote copy of a local wide string, including its terminator. Returns 0 if it couldn't be written.
+		wchar_t* intern(const wchar_t* local_src);
+
+		// Give back a reference taken by intern. Returns false if the pointer isn't a pooled string.
+		bool unref(const void* rmt_str);
+
+		// Start a new generation. Strings remember the generation they were last interned in.
+		void nextGeneration() { current_generation++; }
+		uint32_t generation() const { return current_generation; }
+
+		// Free strings without references that weren't interned during the last max_age generations
+		// (0 frees every string without references). Their space is reused by later strings.
+		// Returns the number of strings freed.
+		size_t collect(uint32_t max_age = 0);
+
+		// Free every page in the target and forget every string.
+		void release();
+
+		const StringPoolStats& stats() const { return pool_stats; }
+
+	private:
+		struct Entry {
+			std::string text;     // Bytes written, including the terminator.
+			uint64_t hash;
+			uint32_t rmt_addr;    // 0 for free entries.
+			uint32_t refs;
+			uint32_t generation;  // Last interned in.
+			uint32_t next;        // Next entry with the same hash, or STRPOOL_NO_ENTRY.
+		};
+
+		HANDLE handle;
+		size_t page_size;
+		std::vector<void*> pages;
+		uint32_t page_pos;            // Bump position in the last page.
+		uint32_t page_left;
+		std::multimap<uint32_t, uint32_t> free_spans;  // Space of collected strings, by size.
+		std::vector<Entry> entries;
+		std::vector<uint32_t> free_entries;
+		std::unordered_map<uint64_t, uint32_t> by_hash;   // First entry of each hash chain.
+		std::unordered_map<uint32_t, uint32_t> by_addr;
+		uint32_t current_generation;
+		StringPoolStats pool_stats;
+
+		void* intern(const void* local_src, size_t len, size_t align);
+		uint32_t place(size_t len, size_t align);
+		void unlink(uint32_t idx);
+	};
+}
\ No newline at end of file
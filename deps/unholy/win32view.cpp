@@ -0,0 +1,286 @@
+#include "win32view.hpp"
+
+// Marks an empty table slot / a missing lookup result.
+#define VIEW_NO_SLAB UINT32_MAX
+
+double Memory::ViewStats::fetchMicros() const {
+	LARGE_INTEGER freq;
+	if (!fetches || !QueryPerformanceFrequency(&freq) || !freq.QuadPart)
+		return 0.0;
+	return static_cast<double>(fetch_ticks) * 1000000.0 / static_cast<double>(freq.QuadPart) / static_cast<double>(fetches);
+}
+
+// ------------------------
+// REMOTE MEMORY VIEW
+// ------------------------
+
+// Pages live in one page aligned allocation ("slabs"), indexed by an open addressing table that is kept
+// at most half full so probes stay short. Entries are removed with backward shift deletion, so the table
+// never fills up with tombstones.
+// Invalidation just bumps the epoch, slabs from an older epoch count as misses and get refetched in place.
+// When every slab is in use the clock algorithm picks one to evict, skipping recently used ones once.
+
+Memory::RemoteMemoryView::RemoteMemoryView(HANDLE rmt_handle, size_t max_pages) : handle(rmt_handle), max_pages(max(max_pages, static_cast<size_t>(2))),
+	slab_base(0), clock_hand(0), epoch(1), last_page(UINT32_MAX), last_epoch(0), last_data(0) {
+	resetStats();
+	slab_base = static_cast<byte*>(VirtualAlloc(0, this->max_pages * VIEW_PAGE_SIZE, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+	if (!slab_base)
+		return;
+
+	slabs.resize(this->max_pages);
+	free_slabs.reserve(this->max_pages);
+	for (size_t i = this->max_pages; i-- > 0;) {
+		slabs[i].used = false;
+		free_slabs.push_back(static_cast<uint32_t>(i));
+	}
+
+	uint32_t bits = 1;
+	while ((1u << bits) < this->max_pages * 2)
+		bits++;
+	table_shift = 32 - bits;
+	table_mask = (1u << bits) - 1;
+	Slot empty = { 0, VIEW_NO_SLAB };
+	table.assign(static_cast<size_t>(1) << bits, empty);
+}
+
+Memory::RemoteMemoryView::~RemoteMemoryView() {
+	if (slab_base)
+		VirtualFree(slab_base, 0, MEM_RELEASE);
+}
+
+// Slab holding a page, or VIEW_NO_SLAB.
+uint32_t Memory::RemoteMemoryView::lookup(uint32_t page) const {
+	for (uint32_t i = (page * 0x9E3779B1u) >> table_shift;; i = (i + 1) & table_mask) {
+		if (table[i].slab == VIEW_NO_SLAB)
+			return VIEW_NO_SLAB;
+		if (table[i].page == page)
+			return table[i].slab;
+	}
+}
+
+void Memory::RemoteMemoryView::insert(uint32_t page, uint32_t slab) {
+	uint32_t i = (page * 0x9E3779B1u) >> table_shift;
+	while (table[i].slab != VIEW_NO_SLAB)
+		i = (i + 1) & table_mask;
+	table[i].page = page;
+	table[i].slab = slab;
+}
+
+// Remove a page from the table, moving later entries of its probe chain back into the hole.
+void Memory::RemoteMemoryView::erase(uint32_t page) {
+	uint32_t i = (page * 0x9E3779B1u) >> table_shift;
+	while (table[i].slab != VIEW_NO_SLAB && table[i].page != page)
+		i = (i + 1) & table_mask;
+	if (table[i].slab == VIEW_NO_SLAB)
+		return;
+
+	uint32_t hole = i;
+	for (uint32_t j = (hole + 1) & table_mask; table[j].slab != VIEW_NO_SLAB; j = (j + 1) & table_mask) {
+		// An entry can fill the hole if its home slot isn't cyclically within (hole, j].
+		uint32_t home = (table[j].page * 0x9E3779B1u) >> table_shift;
+		if (((j - home) & table_mask) >= ((j - hole) & table_mask)) {
+			table[hole] = table[j];
+			hole = j;
+		}
+	}
+	table[hole].slab = VIEW_NO_SLAB;
+}
+
+// Get a free slab, evicting a page if there is none.
+uint32_t Memory::RemoteMemoryView::takeSlab() {
+	if (!free_slabs.empty()) {
+		uint32_t slab = free_slabs.back();
+		free_slabs.pop_back();
+		return slab;
+	}
+
+	for (;;) {
+		SlabInfo& info = slabs[clock_hand];
+		uint32_t slab = clock_hand;
+		clock_hand = (clock_hand + 1) % max_pages;
+		if (info.referenced && info.epoch == epoch) {
+			info.referenced = false;
+			continue;
+		}
+
+		erase(info.page);
+		info.used = false;
+		view_stats.evictions++;
+		if (last_data == slabData(slab))
+			last_page = UINT32_MAX;
+		return slab;
+	}
+}
+
+// Make every page of a list cached and current, fetching them with one readBatch.
+// At most half of the view gets fetched at once, so a fetch never evicts its own pages.
+// Returns the number of pages that could be read.
+size_t Memory::RemoteMemoryView::fetch(const uint32_t* pages, size_t count) {
+	size_t fetched = 0;
+	std::vector<Memory::Remote::ReadEntry> reads;
+	std::vector<uint32_t> read_slabs;
+	for (size_t first = 0; first < count; first += max_pages / 2) {
+		size_t group = min(count - first, max_pages / 2);
+		reads.clear();
+		read_slabs.clear();
+		for (size_t i = first; i < first + group; i++) {
+			uint32_t slab = lookup(pages[i]);
+			if (slab == VIEW_NO_SLAB) {
+				slab = takeSlab();
+				insert(pages[i], slab);
+			}
+
+			// Claimed slabs count as current right away so the clock can't take them back for this group.
+			SlabInfo& info = slabs[slab];
+			info.page = pages[i];
+			info.epoch = epoch;
+			info.used = true;
+			info.referenced = true;
+			Memory::Remote::ReadEntry entry = { reinterpret_cast<void*>(static_cast<uint32_t>(pages[i]) << VIEW_PAGE_SHIFT), VIEW_PAGE_SIZE, slabData(slab), false };
+			reads.push_back(entry);
+			read_slabs.push_back(slab);
+		}
+
+		LARGE_INTEGER start, end;
+		QueryPerformanceCounter(&start);
+		Memory::Remote::readBatch(handle, reads, 0);
+		QueryPerformanceCounter(&end);
+		view_stats.fetches++;
+		view_stats.fetch_ticks += end.QuadPart - start.QuadPart;
+
+		// Unreadable pages don't stay in the table.
+		for (size_t i = 0; i < reads.size(); i++) {
+			SlabInfo& info = slabs[read_slabs[i]];
+			if (reads[i].ok) {
+				fetched++;
+			} else {
+				erase(info.page);
+				info.used = false;
+				free_slabs.push_back(read_slabs[i]);
+			}
+		}
+	}
+
+	return fetched;
+}
+
+// Read path for everything the inline fast path doesn't cover.
+// Pages that miss are fetched together first, then the read is copied out page by page.
+bool Memory::RemoteMemoryView::readSlow(uint32_t addr, byte* local_dst, size_t len) {
+	if (!len)
+		return true;
+	if (!slab_base)
+		return ReadProcessMemory(handle, reinterpret_cast<void*>(addr), local_dst, len, 0) != 0;
+
+	uint32_t first_page = addr >> VIEW_PAGE_SHIFT;
+	uint32_t last = static_cast<uint32_t>((static_cast<uint64_t>(addr) + len - 1) >> VIEW_PAGE_SHIFT);
+	std::vector<uint32_t> missing;
+	for (uint32_t page = first_page; page <= last; page++) {
+		uint32_t slab = lookup(page);
+		if (slab != VIEW_NO_SLAB && slabs[slab].epoch == epoch) {
+			slabs[slab].referenced = true;
+			view_stats.hits++;
+		} else {
+			missing.push_back(page);
+			view_stats.misses++;
+		}
+	}
+
+	if (!missing.empty())
+		fetch(&missing[0], missing.size());
+
+	// Copy out. Reads bigger than half the view may have had early pages evicted again by the fetch,
+	// those parts are read directly.
+	bool ok = true;
+	for (uint32_t page = first_page; page <= last; page++) {
+		uint32_t page_addr = page << VIEW_PAGE_SHIFT;
+		uint32_t from = max(addr, page_addr);
+		uint32_t to = static_cast<uint32_t>(min(static_cast<uint64_t>(addr) + len, static_cast<uint64_t>(page_addr) + VIEW_PAGE_SIZE));
+		byte* dst = local_dst + (from - addr);
+
+		uint32_t slab = lookup(page);
+		if (slab != VIEW_NO_SLAB && slabs[slab].epoch == epoch) {
+			memcpy(dst, slabData(slab) + (from - page_addr), to - from);
+			last_page = page;
+			last_epoch = epoch;
+			last_data = slabData(slab);
+		} else if (!ReadProcessMemory(handle, reinterpret_cast<void*>(from), dst, to - from, 0)) {
+			ok = false;
+		}
+	}
+
+	return ok;
+}
+
+// Write-through: the process is written first, and cached copies are only updated if that worked.
+// If the write fails the affected pages are dropped, since part of it may have landed.
+bool Memory::RemoteMemoryView::write(void* rmt_dst, const void* local_src, size_t len) {
+	bool ok = WriteProcessMemory(handle, rmt_dst, local_src, len, 0) != 0;
+	if (!slab_base || !len)
+		return ok;
+
+	uint32_t addr = reinterpret_cast<uint32_t>(rmt_dst);
+	uint32_t last = static_cast<uint32_t>((static_cast<uint64_t>(addr) + len - 1) >> VIEW_PAGE_SHIFT);
+	for (uint32_t page = addr >> VIEW_PAGE_SHIFT; page <= last; page++) {
+		uint32_t slab = lookup(page);
+		if (slab == VIEW_NO_SLAB)
+			continue;
+
+		if (!ok) {
+			invalidate(reinterpret_cast<void*>(page << VIEW_PAGE_SHIFT), VIEW_PAGE_SIZE);
+			continue;
+		}
+
+		uint32_t page_addr = page << VIEW_PAGE_SHIFT;
+		uint32_t from = max(addr, page_addr);
+		uint32_t to = static_cast<uint32_t>(min(static_cast<uint64_t>(addr) + len, static_cast<uint64_t>(page_addr) + VIEW_PAGE_SIZE));
+		memcpy(slabData(slab) + (from - page_addr), static_cast<const byte*>(local_src) + (from - addr), to - from);
+	}
+
+	return ok;
+}
+
+size_t Memory::RemoteMemoryView::prefetch(const void* rmt_start, size_t len) {
+	if (!slab_base || !len)
+		return 0;
+
+	uint32_t addr = reinterpret_cast<uint32_t>(rmt_start);
+	uint32_t last = static_cast<uint32_t>((static_cast<uint64_t>(addr) + len - 1) >> VIEW_PAGE_SHIFT);
+	std::vector<uint32_t> missing;
+	size_t cached = 0;
+	for (uint32_t page = addr >> VIEW_PAGE_SHIFT; page <= last; page++) {
+		uint32_t slab = lookup(page);
+		if (slab != VIEW_NO_SLAB && slabs[slab].epoch == epoch)
+			cached++;
+		else
+			missing.push_back(page);
+	}
+
+	if (!missing.empty())
+		cached += fetch(&missing[0], missing.size());
+	return cached;
+}
+
+void Memory::RemoteMemoryView::invalidate() {
+	epoch++;
+	view_stats.invalidations++;
+}
+
+void Memory::RemoteMemoryView::invalidate(const void* rmt_start, size_t len) {
+	if (!slab_base || !len)
+		return;
+
+	uint32_t addr = reinterpret_cast<uint32_t>(rmt_start);
+	uint32_t last = static_cast<uint32_t>((static_cast<uint64_t>(addr) + len - 1) >> VIEW_PAGE_SHIFT);
+	for (uint32_t page = addr >> VIEW_PAGE_SHIFT; page <= last; page++) {
+		uint32_t slab = lookup(page);
+		if (slab == VIEW_NO_SLAB)
+			continue;
+
+		erase(page);
+		slabs[slab].used = false;
+		free_slabs.push_back(slab);
+		if (page == last_page)
+			last_page = UINT32_MAX;
+	}
+}
\ No newline at end of file
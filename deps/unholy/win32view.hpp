@@ -0,0 +1,138 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <Windows.h>
+#include <vector>
+
+#include "win32memory.hpp"
+
+// Size of the pages a RemoteMemoryView caches.
+#define VIEW_PAGE_SIZE      0x1000
+#define VIEW_PAGE_SHIFT     12
+
+// Default number of pages a RemoteMemoryView holds (4MB).
+#define VIEW_DEFAULT_PAGES  1024
+
+namespace Memory {
+	// Counters of a RemoteMemoryView.
+	struct ViewStats {
+		uint64_t hits;           // Page accesses served from the cache.
+		uint64_t misses;         // Page accesses that had to be fetched.
+		uint64_t fetches;        // ReadProcessMemory batches issued for misses and prefetches.
+		uint64_t fetch_ticks;    // Total time spent in those, in QueryPerformanceCounter ticks.
+		uint64_t evictions;      // Pages dropped to make room.
+		uint64_t invalidations;  // invalidate() calls.
+
+		// Fraction of page accesses that hit.
+		double hitRate() const { return hits + misses ? static_cast<double>(hits) / (hits + misses) : 0.0; }
+
+		// Average time a fetch took, in microseconds.
+		double fetchMicros() const;
+	};
+
+	// Read-through cache of the memory of a remote process, in whole pages.
+	// Reads that hit are a memcpy out of a local copy of the page, misses fetch every missing page of
+	// the read with one Memory::Remote::readBatch. Writes go straight to the process and update the cache.
+	// Cached pages are never refreshed on their own, call invalidate() whenever the data may have changed
+	// (e.g. once per tick). Not thread safe.
+	class RemoteMemoryView {
+	public:
+		explicit RemoteMemoryView(HANDLE rmt_handle, size_t max_pages = VIEW_DEFAULT_PAGES);
+		~RemoteMemoryView();
+
+		RemoteMemoryView(const RemoteMemoryView&) = delete;
+		RemoteMemoryView& operator=(const RemoteMemoryView&) = delete;
+
+		// Whether the page storage could be allocated.
+		bool valid() const { return slab_base != 0; }
+
+		// Read (remote) memory through the cache. Returns false if any of it couldn't be read.
+		inline bool read(const void* rmt_src, void* local_dst, size_t len) {
+			// Fast path: the whole read is inside the page the last read hit.
+			uint32_t addr = reinterpret_cast<uint32_t>(rmt_src);
+			if ((addr >> VIEW_PAGE_SHIFT) == last_page && last_epoch == epoch && (addr & (VIEW_PAGE_SIZE - 1)) + len <= VIEW_PAGE_SIZE) {
+				memcpy(local_dst, last_data + (addr & (VIEW_PAGE_SIZE - 1)), len);
+				view_stats.hits++;
+				return true;
+			}
+			return readSlow(addr, static_cast<byte*>(local_dst), len);
+		}
+
+		// Read a value of type T through the cache.
+		template <typename T>
+		inline bool read(uint32_t rmt_src, T& value) {
+			return read(reinterpret_cast<const void*>(rmt_src), &value, sizeof(T));
+		}
+
+		// Read a value of type T through the cache, T() if it can't be read.
+		template <typename T>
+		inline T read(uint32_t rmt_src) {
+			T value;
+			if (!read(reinterpret_cast<const void*>(rmt_src), &value, sizeof(T)))
+				return T();
+			return value;
+		}
+
+		// Write to the process and to any cached copy of the memory written.
+		bool write(void* rmt_dst, const void* local_src, size_t len);
+
+		// Write a value of type T to the process and the cache.
+		template <typename T>
+		inline bool write(uint32_t rmt_dst, const T& value) {
+			return write(reinterpret_cast<void*>(rmt_dst), &value, sizeof(T));
+		}
+
+		// Fetch every page of a (remote) range that isn't cached yet.
+		// Returns the number of pages of the range that are cached afterwards.
+		size_t prefetch(const void* rmt_start, size_t len);
+
+		// Mark every cached page stale, they get fetched again on their next access.
+		void invalidate();
+
+		// Drop the cached pages of a (remote) range.
+		void invalidate(const void* rmt_start, size_t len);
+
+		const ViewStats& stats() const { return view_stats; }
+		void resetStats() { memset(&view_stats, 0, sizeof(view_stats)); }
+
+	private:
+		// Open addressing table from page number to slab. Slots with slab == VIEW_NO_SLAB are empty.
+		struct Slot {
+			uint32_t page;
+			uint32_t slab;
+		};
+
+		// A page sized block of slab memory and what it holds.
+		struct SlabInfo {
+			uint32_t page;
+			uint32_t epoch;       // Data is current if this matches the view's epoch.
+			bool used;
+			bool referenced;      // Clock bit for eviction.
+		};
+
+		HANDLE handle;
+		size_t max_pages;
+		byte* slab_base;                 // max_pages * VIEW_PAGE_SIZE bytes, page aligned.
+		std::vector<SlabInfo> slabs;
+		std::vector<uint32_t> free_slabs;
+		std::vector<Slot> table;
+		uint32_t table_shift;
+		uint32_t table_mask;
+		uint32_t clock_hand;
+		uint32_t epoch;
+		ViewStats view_stats;
+
+		// Single entry cache of the last page hit, for the inline fast path.
+		uint32_t last_page;
+		uint32_t last_epoch;
+		const byte* last_data;
+
+		bool readSlow(uint32_t addr, byte* local_dst, size_t len);
+		uint32_t lookup(uint32_t page) const;
+		void insert(uint32_t page, uint32_t slab);
+		void erase(uint32_t page);
+		uint32_t takeSlab();
+		size_t fetch(const uint32_t* pages, size_t count);
+		byte* slabData(uint32_t slab) const { return slab_base + static_cast<size_t>(slab) * VIEW_PAGE_SIZE; }
+	};
+}
\ No newline at end of file
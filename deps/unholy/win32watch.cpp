@@ -0,0 +1,242 @@
+#include "win32watch.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <emmintrin.h>
+
+// Offsets (from the span start) of the 16 byte blocks that differ between two copies of a span.
+static void changedBlocks(const byte* cur, const byte* prev, size_t len, std::vector<uint32_t>& blocks) {
+	blocks.clear();
+	size_t i = 0;
+	for (; i + 16 <= len; i += 16) {
+		__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cur + i));
+		__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + i));
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(a, b)) != 0xFFFF)
+			blocks.push_back(static_cast<uint32_t>(i));
+	}
+	if (i < len && memcmp(cur + i, prev + i, len - i))
+		blocks.push_back(static_cast<uint32_t>(i));
+}
+
+// ------------------------
+// WATCH LIST
+// ------------------------
+
+Memory::WatchList::WatchList(RemoteBackend* backend) : backend(backend), next_id(0), stopping(false), period_ns(0) {
+	memset(&watch_stats, 0, sizeof(watch_stats));
+	resetStats();
+}
+
+Memory::WatchList::~WatchList() {
+	stop();
+}
+
+size_t Memory::WatchList::add(uint32_t rmt_addr, size_t len, const WatchCallback& callback) {
+	std::lock_guard<std::mutex> lock(change_lock);
+	Entry entry = { next_id++, rmt_addr, static_cast<uint32_t>(len), 0, false, callback };
+	added.push_back(entry);
+	return entry.id;
+}
+
+void Memory::WatchList::remove(size_t id) {
+	std::lock_guard<std::mutex> lock(change_lock);
+	removed.push_back(id);
+}
+
+// Apply waiting adds and removes, then lay the entries out into spans again.
+// Entries that stay keep their previous value, moved to wherever they end up in the new layout.
+void Memory::WatchList::rebuild() {
+	std::vector<Entry> new_added;
+	std::vector<size_t> new_removed;
+	{
+		std::lock_guard<std::mutex> lock(change_lock);
+		if (added.empty() && removed.empty())
+			return;
+		new_added.swap(added);
+		new_removed.swap(removed);
+	}
+
+	std::sort(new_removed.begin(), new_removed.end());
+	std::vector<Entry> kept;
+	kept.reserve(entries.size() + new_added.size());
+	for (size_t i = 0; i < entries.size(); i++)
+		if (!std::binary_search(new_removed.begin(), new_removed.end(), entries[i].id))
+			kept.push_back(entries[i]);
+	for (size_t i = 0; i < new_added.size(); i++)
+		if (new_added[i].len && !std::binary_search(new_removed.begin(), new_removed.end(), new_added[i].id))
+			kept.push_back(new_added[i]);
+	std::stable_sort(kept.begin(), kept.end(), [](const Entry& a, const Entry& b) { return a.addr < b.addr; });
+
+	spans.clear();
+	uint32_t total = 0;
+	for (size_t i = 0; i < kept.size(); i++) {
+		uint32_t end = kept[i].addr + kept[i].len;
+		if (!spans.empty()) {
+			Span& last = spans.back();
+			uint32_t last_end = last.addr + last.len;
+			uint32_t new_end = max(last_end, end);
+			if (kept[i].addr <= last_end + WATCH_MERGE_GAP && new_end - last.addr <= WATCH_SPAN_MAX) {
+				total += new_end - last_end;
+				last.len = new_end - last.addr;
+				last.entry_count++;
+				continue;
+			}
+		}
+
+		Span span = { kept[i].addr, kept[i].len, total, static_cast<uint32_t>(i), 1 };
+		spans.push_back(span);
+		total += kept[i].len;
+	}
+
+	std::vector<byte> new_prev(total);
+	for (size_t s = 0; s < spans.size(); s++) {
+		for (uint32_t i = spans[s].first_entry; i < spans[s].first_entry + spans[s].entry_count; i++) {
+			uint32_t offset = spans[s].offset + (kept[i].addr - spans[s].addr);
+			if (kept[i].primed)
+				memcpy(&new_prev[offset], &prev[kept[i].offset], kept[i].len);
+			kept[i].offset = offset;
+		}
+	}
+
+	entries.swap(kept);
+	prev.swap(new_prev);
+	cur.resize(total);
+
+	std::lock_guard<std::mutex> lock(stats_lock);
+	watch_stats.entries = entries.size();
+	watch_stats.spans = spans.size();
+}
+
+// Spans are diffed block by block first, entries only get compared byte for byte if a changed block
+// overlaps them. Entries are sorted by address, so the first block that can overlap an entry only
+// ever moves forward within a span.
+size_t Memory::WatchList::poll() {
+	rebuild();
+
+	reads.clear();
+	for (size_t s = 0; s < spans.size(); s++) {
+		Memory::Remote::ReadEntry read = { reinterpret_cast<void*>(spans[s].addr), spans[s].len, &cur[spans[s].offset], false };
+		reads.push_back(read);
+	}
+	if (!reads.empty())
+		backend->readBatch(&reads[0], reads.size());
+
+	size_t changes = 0;
+	uint64_t failures = 0;
+	for (size_t s = 0; s < spans.size(); s++) {
+		const Span& span = spans[s];
+		if (!reads[s].ok) {
+			// Keep the old values for next time.
+			memcpy(&cur[span.offset], &prev[span.offset], span.len);
+			failures++;
+			continue;
+		}
+
+		changedBlocks(&cur[span.offset], &prev[span.offset], span.len, changed_blocks);
+		size_t block = 0;
+		for (uint32_t i = span.first_entry; i < span.first_entry + span.entry_count; i++) {
+			Entry& entry = entries[i];
+			if (!entry.primed) {
+				entry.primed = true;
+				continue;
+			}
+
+			uint32_t start = entry.offset - span.offset;
+			while (block < changed_blocks.size() && changed_blocks[block] + 16 <= start)
+				block++;
+			if (block == changed_blocks.size() || changed_blocks[block] >= start + entry.len)
+				continue;
+			if (!memcmp(&cur[entry.offset], &prev[entry.offset], entry.len))
+				continue;
+
+			changes++;
+			WatchEvent event = { entry.id, entry.addr, entry.len, &prev[entry.offset], &cur[entry.offset] };
+			entry.callback(event);
+		}
+	}
+	cur.swap(prev);
+
+	std::lock_guard<std::mutex> lock(stats_lock);
+	watch_stats.polls++;
+	watch_stats.changes += changes;
+	watch_stats.read_failures += failures;
+	return changes;
+}
+
+void Memory::WatchList::start(double hz) {
+	if (running())
+		return;
+	setRate(hz);
+	stopping = false;
+	thread = std::thread(&WatchList::run, this);
+}
+
+void Memory::WatchList::setRate(double hz) {
+	period_ns = static_cast<long long>(1000000000.0 / max(hz, 0.001));
+	std::lock_guard<std::mutex> lock(stats_lock);
+	watch_stats.period = static_cast<double>(period_ns) / 1000.0;
+}
+
+void Memory::WatchList::stop() {
+	stopping = true;
+	if (thread.joinable())
+		thread.join();
+}
+
+// Polls are scheduled on a fixed grid so lateness doesn't add up. Sleeping is only accurate to the
+// scheduler's tick, so the thread sleeps until shortly before a poll is due and yields from there.
+// If a poll overruns the grid restarts from now instead of firing the missed polls back to back.
+void Memory::WatchList::run() {
+	typedef std::chrono::steady_clock clock;
+	clock::time_point due = clock::now();
+	while (!stopping) {
+		clock::time_point early = due - std::chrono::milliseconds(2);
+		if (clock::now() < early)
+			std::this_thread::sleep_until(early);
+		while (clock::now() < due)
+			std::this_thread::yield();
+
+		clock::time_point start = clock::now();
+		poll();
+		clock::time_point end = clock::now();
+
+		std::chrono::nanoseconds period(period_ns.load());
+		double jitter = std::chrono::duration<double, std::micro>(start - due).count();
+		double took = std::chrono::duration<double, std::micro>(end - start).count();
+		{
+			std::lock_guard<std::mutex> lock(stats_lock);
+			timed_polls++;
+			jitter_total += jitter;
+			poll_total += took;
+			watch_stats.jitter_max = max(watch_stats.jitter_max, jitter);
+			if (end - start > period)
+				watch_stats.overruns++;
+		}
+
+		due += period;
+		if (due < end)
+			due = end;
+	}
+}
+
+Memory::WatchStats Memory::WatchList::stats() {
+	std::lock_guard<std::mutex> lock(stats_lock);
+	WatchStats s = watch_stats;
+	s.jitter_mean = timed_polls ? jitter_total / timed_polls : 0.0;
+	s.poll_mean = timed_polls ? poll_total / timed_polls : 0.0;
+	return s;
+}
+
+void Memory::WatchList::resetStats() {
+	std::lock_guard<std::mutex> lock(stats_lock);
+	size_t entry_count = watch_stats.entries;
+	size_t span_count = watch_stats.spans;
+	double period = static_cast<double>(period_ns) / 1000.0;
+	memset(&watch_stats, 0, sizeof(watch_stats));
+	watch_stats.entries = entry_count;
+	watch_stats.spans = span_count;
+	watch_stats.period = period;
+	timed_polls = 0;
+	jitter_total = 0.0;
+	poll_total = 0.0;
+}
\ No newline at end of file
@@ -0,0 +1,126 @@
+#pragma once
+#include <stdint.h>
+#include <Windows.h>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "win32backend.hpp"
+
+// Watched entries at most this many bytes apart are read as one span.
+#define WATCH_MERGE_GAP   0x40
+
+// Largest span merging makes.
+#define WATCH_SPAN_MAX    0x1000
+
+namespace Memory {
+	// A change of a watched entry.
+	struct WatchEvent {
+		size_t id;
+		uint32_t address;
+		size_t len;
+		const byte* old_value;
+		const byte* new_value;
+	};
+
+	typedef std::function<void(const WatchEvent& event)> WatchCallback;
+
+	// Counters of a WatchList. Times are in microseconds and only cover polls made by the polling thread.
+	struct WatchStats {
+		uint64_t polls;
+		uint64_t changes;        // Entries whose value changed.
+		uint64_t read_failures;  // Spans that couldn't be read.
+		size_t entries;
+		size_t spans;
+		double period;           // Time between polls asked for.
+		double jitter_mean;      // How late polls started, on average and at worst.
+		double jitter_max;
+		double poll_mean;        // How long a poll took, on average.
+		uint64_t overruns;       // Polls that took longer than the period.
+	};
+
+	// Polls a set of (remote) memory ranges for changes.
+	// Entries close to each other are merged into spans, each poll reads every span with one
+	// RemoteBackend::readBatch, compares them with the previous poll 16 bytes at a time and calls back
+	// for the entries that changed. A new entry's first value doesn't count as a change.
+	class WatchList {
+	public:
+		explicit WatchList(RemoteBackend* backend);
+		~WatchList();
+
+		WatchList(const WatchList&) = delete;
+		WatchList& operator=(const WatchList&) = delete;
+
+		// Watch len bytes at a (remote) address. Returns the id of the entry.
+		// Can be called from any thread and from callbacks, it takes effect on the next poll.
+		size_t add(uint32_t rmt_addr, size_t len, const WatchCallback& callback);
+
+		// Stop watching an entry. Takes effect on the next poll.
+		void remove(size_t id);
+
+		// Read every entry once and call back for the ones that changed. Returns the number of changes.
+		// Callbacks run on the calling thread. Don't call this while the polling thread runs.
+		size_t poll();
+
+		// Poll on a thread of its own, hz times a second.
+		void start(double hz);
+
+		// Change the rate of the polling thread.
+		void setRate(double hz);
+
+		// Stop the polling thread.
+		void stop();
+
+		bool running() const { return thread.joinable(); }
+
+		WatchStats stats();
+		void resetStats();
+
+	private:
+		struct Entry {
+			size_t id;
+			uint32_t addr;
+			uint32_t len;
+			uint32_t offset;  // Of its bytes in the value buffers.
+			bool primed;      // Whether it has a previous value.
+			WatchCallback callback;
+		};
+
+		// Entries [first_entry, first_entry + entry_count) are read together as one range.
+		struct Span {
+			uint32_t addr;
+			uint32_t len;
+			uint32_t offset;
+			uint32_t first_entry;
+			uint32_t entry_count;
+		};
+
+		RemoteBackend* backend;
+		std::vector<Entry> entries;  // Sorted by address.
+		std::vector<Span> spans;
+		std::vector<byte> cur;       // Values read by the last poll and the one before, span after span.
+		std::vector<byte> prev;
+		std::vector<Memory::Remote::ReadEntry> reads;
+		std::vector<uint32_t> changed_blocks;
+
+		// Changes to the entry set waiting for the next poll.
+		std::mutex change_lock;
+		std::vector<Entry> added;
+		std::vector<size_t> removed;
+		size_t next_id;
+
+		std::thread thread;
+		std::atomic<bool> stopping;
+		std::atomic<long long> period_ns;
+		std::mutex stats_lock;
+		WatchStats watch_stats;
+		uint64_t timed_polls;       // Polls of the polling thread, and their total jitter and duration.
+		double jitter_total;
+		double poll_total;
+
+		void rebuild();
+		void run();
+	};
+}
\ No newline at end of file
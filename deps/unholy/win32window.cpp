@@ -0,0 +1,100 @@
+#include "win32window.hpp"
+
+// Not in the SDK headers, loaded from ntdll.
+typedef LONG(NTAPI* NtMapViewOfSection_t)(HANDLE, HANDLE, PVOID*, ULONG_PTR, SIZE_T, PLARGE_INTEGER, PSIZE_T, DWORD, ULONG, ULONG);
+typedef LONG(NTAPI* NtUnmapViewOfSection_t)(HANDLE, PVOID);
+typedef ULONG(NTAPI* RtlNtStatusToDosError_t)(LONG);
+
+// ViewUnmap of SECTION_INHERIT, the view isn't inherited by child processes.
+#define VIEW_UNMAP 2
+
+static NtMapViewOfSection_t ntMapViewOfSection() {
+	static NtMapViewOfSection_t func = reinterpret_cast<NtMapViewOfSection_t>(GetProcAddress(GetModuleHandleA("ntdll.dll"), "NtMapViewOfSection"));
+	return func;
+}
+
+static NtUnmapViewOfSection_t ntUnmapViewOfSection() {
+	static NtUnmapViewOfSection_t func = reinterpret_cast<NtUnmapViewOfSection_t>(GetProcAddress(GetModuleHandleA("ntdll.dll"), "NtUnmapViewOfSection"));
+	return func;
+}
+
+static RtlNtStatusToDosError_t rtlNtStatusToDosError() {
+	static RtlNtStatusToDosError_t func = reinterpret_cast<RtlNtStatusToDosError_t>(GetProcAddress(GetModuleHandleA("ntdll.dll"), "RtlNtStatusToDosError"));
+	return func;
+}
+
+// ------------------------
+// SHARED WINDOW
+// ------------------------
+
+// The local view is mapped with MapViewOfFile, the remote one with NtMapViewOfSection since the Win32
+// function for that (MapViewOfFile2) only exists on Windows 10 and later.
+// The section handle is kept open, the views stay valid until both are unmapped either way.
+Memory::SharedWindow::SharedWindow(HANDLE rmt_handle, size_t size, bool executable) : handle(rmt_handle), section(0), local_base(0), rmt_base(0),
+	view_size(0), alloc_offset(0), last_error(ERROR_SUCCESS), nt_status(0) {
+	view_size = (max(size, static_cast<size_t>(1)) + 0xFFF) & ~static_cast<size_t>(0xFFF);
+	DWORD protect = executable ? PAGE_EXECUTE_READWRITE : PAGE_READWRITE;
+	section = CreateFileMappingA(INVALID_HANDLE_VALUE, 0, protect | SEC_COMMIT, 0, static_cast<DWORD>(view_size), 0);
+	if (!section) {
+		last_error = GetLastError();
+		return;
+	}
+
+	local_base = static_cast<byte*>(MapViewOfFile(section, FILE_MAP_READ | FILE_MAP_WRITE | (executable ? FILE_MAP_EXECUTE : 0), 0, 0, view_size));
+	if (!local_base) {
+		last_error = GetLastError();
+		return;
+	}
+
+	NtMapViewOfSection_t map = ntMapViewOfSection();
+	if (!map) {
+		last_error = ERROR_PROC_NOT_FOUND;
+		return;
+	}
+
+	SIZE_T rmt_size = view_size;
+	LONG status = map(section, handle, &rmt_base, 0, 0, 0, &rmt_size, VIEW_UNMAP, 0, protect);
+	if (status < 0) {
+		rmt_base = 0;
+		nt_status = status;
+		RtlNtStatusToDosError_t convert = rtlNtStatusToDosError();
+		last_error = convert ? convert(status) : ERROR_ACCESS_DENIED;
+	}
+}
+
+Memory::SharedWindow::~SharedWindow() {
+	NtUnmapViewOfSection_t unmap = ntUnmapViewOfSection();
+	if (rmt_base && unmap)
+		unmap(handle, rmt_base);
+	if (local_base)
+		UnmapViewOfFile(local_base);
+	if (section)
+		CloseHandle(section);
+}
+
+uint32_t Memory::SharedWindow::toRemote(const void* local_ptr) const {
+	const byte* ptr = static_cast<const byte*>(local_ptr);
+	if (!valid() || ptr < local_base || ptr >= local_base + view_size)
+		return 0;
+	return remoteBase() + static_cast<uint32_t>(ptr - local_base);
+}
+
+void* Memory::SharedWindow::toLocal(uint32_t rmt_addr) const {
+	if (!valid() || rmt_addr < remoteBase() || rmt_addr - remoteBase() >= view_size)
+		return 0;
+	return local_base + (rmt_addr - remoteBase());
+}
+
+// Plain bump allocation, zeroed on the way out since reset() leaves old contents behind.
+void* Memory::SharedWindow::alloc(size_t len, size_t align) {
+	if (!valid())
+		return 0;
+
+	size_t offset = (alloc_offset + align - 1) & ~(align - 1);
+	if (offset + len > view_size || offset + len < offset)
+		return 0;
+
+	alloc_offset = offset + len;
+	memset(local_base + offset, 0, len);
+	return local_base + offset;
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <Windows.h>
+#include <new>
+#include <type_traits>
+
+namespace Memory {
+	// Block of memory shared between this process and a remote one.
+	// A section (page file backed file mapping) is mapped into both processes, so after setup both sides
+	// see each other's loads and stores directly, without any ReadProcessMemory / WriteProcessMemory.
+	// Fields written by one side while the other reads them should be volatile or accessed with
+	// interlocked functions. The remote handle needs PROCESS_VM_OPERATION.
+	class SharedWindow {
+	public:
+		// Create a window of size bytes (rounded up to pages) and map it into a remote process.
+		// If executable is set, both views are PAGE_EXECUTE_READWRITE (e.g. for hooks placed inside the window).
+		SharedWindow(HANDLE rmt_handle, size_t size, bool executable = false);
+		~SharedWindow();
+
+		SharedWindow(const SharedWindow&) = delete;
+		SharedWindow& operator=(const SharedWindow&) = delete;
+
+		// Whether both views could be mapped.
+		bool valid() const { return local_base && rmt_base; }
+
+		// Why the window isn't valid, a GetLastError() style code.
+		DWORD error() const { return last_error; }
+
+		// NTSTATUS of mapping the remote view if that failed, otherwise 0.
+		LONG ntStatus() const { return nt_status; }
+
+		byte* localBase() const { return local_base; }
+		uint32_t remoteBase() const { return reinterpret_cast<uint32_t>(rmt_base); }
+		size_t size() const { return view_size; }
+
+		// Translate between the two views. Pointers outside the window translate to 0.
+		uint32_t toRemote(const void* local_ptr) const;
+		void* toLocal(uint32_t rmt_addr) const;
+
+		// Local pointer to a T at a remote address in the window.
+		template <typename T>
+		inline T* toLocal(uint32_t rmt_addr) const { return static_cast<T*>(toLocal(rmt_addr)); }
+
+		// Carve len bytes out of the window. Returns the local pointer, or 0 if the window is full.
+		// The memory is zeroed.
+		void* alloc(size_t len, size_t align = 8);
+
+		// Carve count default constructed Ts out of the window. Returns the local pointer, or 0 if the
+		// window is full. T must not hold pointers into this process, the remote side can't use them.
+		template <typename T>
+		inline T* alloc(size_t count = 1) {
+			static_assert(std::is_trivially_destructible<T>::value, "objects in a shared window are never destroyed");
+			T* obj = static_cast<T*>(alloc(sizeof(T) * count, alignof(T)));
+			if (obj)
+				for (size_t i = 0; i < count; i++)
+					new (obj + i) T();
+			return obj;
+		}
+
+		// Bytes carved out so far.
+		size_t used() const { return alloc_offset; }
+
+		// Give back everything carved out. The memory is zeroed again by the next alloc of it.
+		void reset() { alloc_offset = 0; }
+
+	private:
+		HANDLE handle;
+		HANDLE section;
+		byte* local_base;
+		void* rmt_base;
+		size_t view_size;
+		size_t alloc_offset;
+		DWORD last_error;
+		LONG nt_status;
+	};
+}
\ No newline at end of file
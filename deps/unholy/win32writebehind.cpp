@@ -0,0 +1,152 @@
+#include "win32writebehind.hpp"
+
+#include <chrono>
+
+// ------------------------
+// WRITE BEHIND
+// ------------------------
+
+Memory::WriteBehind::WriteBehind(HANDLE rmt_handle) : handle(rmt_handle), segments(1), stopping(false), interval(0) {
+	memset(&wb_stats, 0, sizeof(wb_stats));
+}
+
+Memory::WriteBehind::~WriteBehind() {
+	stop();
+	commit();
+}
+
+// Writes into a pending range are a memcpy. Otherwise every range the write overlaps or touches is
+// merged with it into one, the write's bytes winning where they overlap.
+void Memory::WriteBehind::write(uint32_t rmt_dst, const void* local_src, size_t len) {
+	if (!len)
+		return;
+	const byte* src = static_cast<const byte*>(local_src);
+	uint64_t end = static_cast<uint64_t>(rmt_dst) + len;
+
+	std::lock_guard<std::mutex> lock(shadow_lock);
+	wb_stats.writes++;
+	Segment& spans = segments.back();
+	auto first = spans.upper_bound(rmt_dst);
+	if (first != spans.begin()) {
+		auto prev = std::prev(first);
+		uint64_t prev_end = static_cast<uint64_t>(prev->first) + prev->second.size();
+		if (end <= prev_end) {
+			memcpy(&prev->second[rmt_dst - prev->first], src, len);
+			wb_stats.merged++;
+			return;
+		}
+		if (prev_end >= rmt_dst)
+			first = prev;
+	}
+
+	auto last = first;
+	uint32_t start = rmt_dst;
+	uint64_t merged_end = end;
+	for (; last != spans.end() && last->first <= end; ++last) {
+		start = min(start, last->first);
+		merged_end = max(merged_end, static_cast<uint64_t>(last->first) + last->second.size());
+	}
+	if (first != last)
+		wb_stats.merged++;
+
+	std::vector<byte> merged(static_cast<size_t>(merged_end - start));
+	for (auto it = first; it != last; ++it)
+		memcpy(&merged[it->first - start], &it->second[0], it->second.size());
+	memcpy(&merged[rmt_dst - start], src, len);
+	spans.erase(first, last);
+	spans[start].swap(merged);
+}
+
+void Memory::WriteBehind::barrier() {
+	std::lock_guard<std::mutex> lock(shadow_lock);
+	if (!segments.back().empty())
+		segments.push_back(Segment());
+}
+
+// The pending ranges are taken out under the shadow lock, so writers only wait for that, not for the
+// process. Each segment is one WriteBatch commit, in order, so barriers hold.
+bool Memory::WriteBehind::commit() {
+	std::lock_guard<std::mutex> order(commit_lock);
+	std::vector<Segment> flushing(1);
+	{
+		std::lock_guard<std::mutex> lock(shadow_lock);
+		if (segments.size() == 1 && segments[0].empty())
+			return true;
+		flushing.swap(segments);
+	}
+
+	uint64_t spans = 0, bytes = 0, failures = 0, syscalls = 0;
+	for (size_t s = 0; s < flushing.size(); s++) {
+		if (flushing[s].empty())
+			continue;
+		Memory::Remote::WriteBatch batch(handle);
+		for (auto it = flushing[s].begin(); it != flushing[s].end(); ++it) {
+			batch.add(reinterpret_cast<void*>(it->first), &it->second[0], it->second.size());
+			bytes += it->second.size();
+		}
+		spans += flushing[s].size();
+		failures += flushing[s].size() - batch.commit();
+		syscalls += batch.syscalls();
+	}
+
+	std::lock_guard<std::mutex> lock(shadow_lock);
+	wb_stats.commits++;
+	wb_stats.spans += spans;
+	wb_stats.bytes += bytes;
+	wb_stats.failures += failures;
+	wb_stats.syscalls += syscalls;
+	return failures == 0;
+}
+
+void Memory::WriteBehind::discard() {
+	std::lock_guard<std::mutex> lock(shadow_lock);
+	segments.assign(1, Segment());
+}
+
+size_t Memory::WriteBehind::pending() {
+	std::lock_guard<std::mutex> lock(shadow_lock);
+	size_t bytes = 0;
+	for (size_t s = 0; s < segments.size(); s++)
+		for (auto it = segments[s].begin(); it != segments[s].end(); ++it)
+			bytes += it->second.size();
+	return bytes;
+}
+
+void Memory::WriteBehind::start(DWORD interval_ms) {
+	if (running())
+		return;
+	interval = interval_ms;
+	stopping = false;
+	thread = std::thread(&WriteBehind::run, this);
+}
+
+void Memory::WriteBehind::stop() {
+	stopping = true;
+	if (thread.joinable())
+		thread.join();
+}
+
+void Memory::WriteBehind::run() {
+	typedef std::chrono::steady_clock clock;
+	clock::time_point due = clock::now();
+	while (!stopping) {
+		due += std::chrono::milliseconds(interval);
+		if (clock::now() < due)
+			std::this_thread::sleep_until(due);
+		commit();
+
+		clock::time_point now = clock::now();
+		if (due < now)
+			due = now;
+	}
+}
+
+Memory::WriteBehindStats Memory::WriteBehind::stats() {
+	std::lock_guard<std::mutex> lock(shadow_lock);
+	return wb_stats;
+}
+
+void Memory::WriteBehind::resetStats() {
+	std::lock_guard<std::mutex> lock(shadow_lock);
+	memset(&wb_stats, 0, sizeof(wb_stats));
+}
\ No newline at end of file
@@ -0,0 +1,91 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <Windows.h>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "win32memory.hpp"
+
+namespace Memory {
+	// Counters of a WriteBehind.
+	struct WriteBehindStats {
+		uint64_t writes;     // write calls.
+		uint64_t merged;     // Of those, absorbed into a range already pending.
+		uint64_t commits;    // Commits that had something to write.
+		uint64_t spans;      // Ranges written by those.
+		uint64_t bytes;
+		uint64_t failures;   // Ranges that couldn't be written.
+		uint64_t syscalls;   // System calls the commits made.
+	};
+
+	// Buffers writes to a remote process and applies only the latest bytes of each address, at a commit.
+	// Writes go to a local shadow of the pending bytes, ordered by address. A write to bytes that are
+	// already pending overwrites them in the shadow, and writes that overlap or touch merge into one range.
+	// A commit writes every range with one Memory::Remote::WriteBatch. Ranges written after a barrier() land
+	// after everything written before it. Thread safe, so a timer thread can commit while others write.
+	//   Memory::WriteBehind wb(handle);
+	//   wb.write(rmt_pos, pos);       // Any number of times per frame.
+	//   wb.commit();                  // Once per frame.
+	class WriteBehind {
+	public:
+		explicit WriteBehind(HANDLE rmt_handle);
+
+		// Stops the commit thread and commits what's pending.
+		~WriteBehind();
+
+		WriteBehind(const WriteBehind&) = delete;
+		WriteBehind& operator=(const WriteBehind&) = delete;
+
+		// Queue a write of len bytes to a (remote) address, the data is copied.
+		void write(uint32_t rmt_dst, const void* local_src, size_t len);
+
+		// Queue a write of a value of type T.
+		template <typename T>
+		inline void write(uint32_t rmt_dst, const T& value) {
+			write(rmt_dst, &value, sizeof(T));
+		}
+
+		// Make writes queued from now on land after the ones queued so far, even within one commit.
+		void barrier();
+
+		// Write everything pending. Returns false if any range couldn't be written.
+		bool commit();
+
+		// Drop everything pending without writing it.
+		void discard();
+
+		// Commit on a thread of its own, every interval_ms milliseconds.
+		void start(DWORD interval_ms);
+
+		// Stop the commit thread.
+		void stop();
+
+		bool running() const { return thread.joinable(); }
+
+		// Bytes waiting for the next commit.
+		size_t pending();
+
+		WriteBehindStats stats();
+		void resetStats();
+
+	private:
+		// Pending ranges written between two barriers, by start address.
+		typedef std::map<uint32_t, std::vector<byte>> Segment;
+
+		HANDLE handle;
+		std::mutex shadow_lock;
+		std::vector<Segment> segments;  // Oldest first, never empty.
+		std::mutex commit_lock;         // Keeps commits in order.
+		WriteBehindStats wb_stats;
+
+		std::thread thread;
+		std::atomic<bool> stopping;
+		DWORD interval;
+
+		void run();
+	};
+}
\ No newline at end of file
@@ -1,3 +1,10 @@
+#include <stdio.h>
+#include <stdint.h>
+#include <Windows.h>
+
+#include "unholy/win32memory.hpp"
+#include "unholy/win32autoio.hpp"
+
 // TODO: make memory demo... I've been busy...
 
 // The memory functions are fairly standard and straightforward so
@@ -5,6 +12,36 @@
 // from the given documentation until I get around to making some
 // examples in here.
 
-int main() {
+// For now this benchmarks the ways Memory::AutoBackend can read another
+// process and prints where they cross over.
+// Usage: MemoryDemo.exe [target.exe]  (defaults to reading itself)
+
+int main(int argc, char** argv) {
+	uint32_t pid = argc > 1 ? Memory::Remote::getPid(argv[1]) : GetCurrentProcessId();
+	if (!pid) {
+		printf("%s isn't running\n", argv[1]);
+		return 1;
+	}
+
+	Memory::AutoBackend backend(pid);
+	const Memory::IoCalibration& calib = backend.calibration();
+	if (!backend.processHandle() || !calib.done) {
+		printf("couldn't open or read process %u\n", pid);
+		return 1;
+	}
+
+	printf("%10s %14s %14s\n", "bytes", "Win32 (us)", "native (us)");
+	for (size_t i = 0; i < IO_CALIBRATION_SIZES; i++) {
+		if (calib.micros[Memory::IO_WIN32][i] == 0.0)
+			break;
+		printf("%10u %14.3f %14.3f\n", static_cast<uint32_t>(calib.sizes[i]), calib.micros[Memory::IO_WIN32][i], calib.micros[Memory::IO_NATIVE][i]);
+	}
+
+	if (calib.native_max)
+		printf("native API used up to %u bytes, Win32 above\n", static_cast<uint32_t>(calib.native_max));
+	else
+		printf("Win32 API used for every size\n");
+
+	Memory::Remote::closeCachedHandles();
 	return 0;
 }
\ No newline at end of file